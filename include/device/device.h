@@ -5,9 +5,13 @@
 #include <initializer_list>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <vector>
 
+#include <device/envelope.h>
 #include <device/event.h>
+#include <device/record.h>
+#include <queue/element_buffer.h>
 #include <queue/iqueue.h>
 #include <queue/queue.h>
 #include <queue/queue_reader.h>
@@ -26,11 +30,25 @@ class GenericDevice
 {
 public:
 	typedef std::function<bool(InputT)> InputDomain;
-	typedef std::function<bool(OutputT)> OutputDomain;
+	typedef std::function<bool(OutputT const&)> OutputDomain;
 	typedef std::function<OutputT(InputT)> ResolutionFunction;
-	typedef std::function<StateT(StateT, InputT, OutputT)> StateFunction;
+	typedef std::function<StateT(StateT, InputT, OutputT const&)> StateFunction;
+
+	// writes the output into the one given, which may hold an old value
+	typedef std::function<void(InputT, OutputT &)> InPlaceResolution;
 	typedef std::function<Event<EventT>(StateT)> EventFunction;
 	typedef std::vector<EventFunction> EventList;
+	typedef Record<OutputT, EventT> DeviceRecord;
+	typedef Envelope<OutputT> OutputEnvelope;
+	typedef Envelope<Event<EventT>> EventEnvelope;
+
+	// Level writes every event, Edge only events whose type differs
+	// from the last one written by the same event function
+	enum class Trigger
+	{
+		Level,
+		Edge
+	};
 
 	GenericDevice();
 	GenericDevice(GenericDevice<
@@ -55,35 +73,169 @@ public:
 			StateFunction,
 			std::initializer_list<EventFunction>);
 
+	// resolves straight into a slot when the output queue lends one, a
+	// RingQueue output then never copies the output
+	GenericDevice(
+			InputDomain,
+			OutputDomain,
+			InPlaceResolution,
+			StateFunction,
+			std::initializer_list<EventFunction>);
+
 	virtual ~GenericDevice() = default;
 	GenericDevice<InputT, OutputT, StateT, EventT>
 	combine(GenericDevice<InputT, OutputT, StateT, EventT> const&);
 
+	// reads the stamped outputs of the other device, so its stamps carry
+	// on through this one whenever envelope readers connect
 	template<typename OtherInputT, typename OtherStateT, typename OtherEventT>
 	void connect(GenericDevice<OtherInputT, InputT, OtherStateT, OtherEventT> const&);
+
+	// replaces the output queue of the other device with the given link
+	// readers already connected to the other device keep the old queue
+	template<typename OtherInputT, typename OtherStateT, typename OtherEventT>
+	void connect(GenericDevice<OtherInputT, InputT, OtherStateT, OtherEventT> &,
+			std::shared_ptr<IQueue<InputT>>);
+
 	void connect(QueueReader<InputT>);
+
+	// reads inputs stamped upstream, their stamps carry on to outputs
+	// and events; replaces the plain input connection
+	void connect(QueueReader<Envelope<InputT>>);
+
+	// readers compete for outputs, unless the output queue is a
+	// BroadcastQueue where each reader sees every output
 	void connect(QueueReader<OutputT> &);
 	void connect(QueueReader<Event<EventT>> &);
+
+	// merged record stream, created if needed, written alongside the
+	// plain output and event queues
+	void connect(QueueReader<DeviceRecord> &);
+
+	// stamped outputs and events, written alongside the plain ones
+	// while connected, inputs read without a stamp get one here
+	void connect(QueueReader<OutputEnvelope> &);
+	void connect(QueueReader<EventEnvelope> &);
 	void disconnect();
 
 	bool read();
 	bool read(InputT);
+	bool read(Envelope<InputT>);
+
+	// reads the inputs in order and writes their outputs and events
+	// in one bulk enqueue per queue, returns the number in domain
+	size_t read(InputT const*, size_t);
+	size_t read(Envelope<InputT> const*, size_t);
+
+	// reads up to max inputs from the connection in one bulk dequeue,
+	// returns the number dequeued
+	// throws std::runtime_error if no input is connected
+	size_t pump(size_t max);
+
 	StateT state();
 
+	// id put in the stamps of inputs read by this device, 0 by default
+	void setDeviceId(uint32_t);
+
+	// sets the trigger of all event functions, or of one of them
+	// throws std::out_of_range if there is no such event function
+	void setTrigger(Trigger);
+	void setTrigger(size_t eventFunction, Trigger);
+
+	// number of events held back by Edge triggers, in total or of one
+	// event function; events nobody reads aren't counted, though Edge
+	// triggers still follow them
+	// throws std::out_of_range if there is no such event function
+	size_t suppressed() const;
+	size_t suppressed(size_t eventFunction) const;
+
+	// number of outputs, events and records dropped because their
+	// queue was full, e.g. a RingQueue nobody drained in time
+	size_t drops() const;
+
+	// selects the queue outputs are written to, e.g. a RingQueue
+	// for a link with a single reader; always written, the queue may be
+	// read out of process or directly, only the device's own queues are
+	// skipped while nobody reads them
+	void setOutputQueue(std::shared_ptr<IQueue<OutputT>>);
+
+	// while set, outputs and events of each input are also written to
+	// this queue, in one bulk enqueue; plain queues keep getting them
+	// while they have readers; always written, like a set output queue
+	void setRecordQueue(std::shared_ptr<IQueue<DeviceRecord>>);
+
 	void swap(GenericDevice<InputT, OutputT, StateT, EventT> &);
 
 private:
-	std::shared_ptr<Queue<OutputT>> pOutputQueue;
-	std::shared_ptr<Queue<Event<EventT>>> pEventQueue;
+	template<typename, typename, typename, typename>
+	friend class GenericDevice;
+
+	std::shared_ptr<IQueue<OutputT>> pOutputQueue;
+	std::shared_ptr<IQueue<Event<EventT>>> pEventQueue;
+	std::unique_ptr<typename IQueue<OutputT>::Producer> pOutputProducer;
+	std::unique_ptr<typename IQueue<Event<EventT>>::Producer> pEventProducer;
+	std::shared_ptr<IQueue<DeviceRecord>> pRecordQueue;
+	std::unique_ptr<typename IQueue<DeviceRecord>::Producer> pRecordProducer;
+	std::vector<DeviceRecord> mRecords;
+	uint64_t mInputs;
+	size_t mDrops;
+
+	// set through setOutputQueue() or setRecordQueue(), so written even
+	// without in-process readers
+	bool mOutputSupplied;
+	bool mRecordSupplied;
+
+	// created by the first envelope reader or chained device, null costs
+	// nothing
+	mutable std::shared_ptr<IQueue<OutputEnvelope>> pOutputEnvelopeQueue;
+	std::shared_ptr<IQueue<EventEnvelope>> pEventEnvelopeQueue;
+	mutable std::unique_ptr<typename IQueue<OutputEnvelope>::Producer> pOutputEnvelopeProducer;
+	std::unique_ptr<typename IQueue<EventEnvelope>::Producer> pEventEnvelopeProducer;
+	uint32_t mDeviceId;
+
+	// reused by reads, InputT needs no default constructor
+	ElementBuffer<InputT> mInputBuffer;
+	ElementBuffer<Envelope<InputT>> mEnvelopeBuffer;
+	std::vector<OutputT> mOutputBuffer;
+	std::vector<Event<EventT>> mEventBuffer;
+
+	struct EventEdge
+	{
+		Trigger trigger = Trigger::Level;
+		bool fired = false;
+		Event<EventT> last;
+		size_t suppressed = 0;
+	};
+
+	// events of the current input that passed their triggers
+	std::vector<Event<EventT>> mFired;
+	std::vector<EventEdge> mEdges;
 
 	InputDomain mInputDomain;
 	OutputDomain mOutputDomain;
 	ResolutionFunction mResolutionFunction;
+	InPlaceResolution mInPlaceResolution;
 	StateFunction mStateFunction;
 	EventList mEventList;
 	QueueReader<InputT> mInputConnection;
+	QueueReader<Envelope<InputT>> mEnvelopeConnection;
+	bool mEnveloped;
 	StateT mCurrentState;
 
+	bool process(InputT const&, Stamp const*);
+	bool outputsRead() const;
+	bool recordsRead() const;
+
+	// either inputs or envelopes is null
+	size_t process(InputT const* inputs, Envelope<InputT> const* envelopes,
+			size_t count);
+	void write(InputT const&, Stamp const*, OutputT & output, bool claimed);
+	void fire(StateT const&, std::vector<Event<EventT>> &);
+	void track(StateT const&);
+	void writeEnvelopes(Stamp const&, OutputT const&);
+	std::shared_ptr<IQueue<OutputEnvelope>> const& outputEnvelopeQueue() const;
+	EventEdge & edge(size_t eventFunction);
+
 };// class GenericDevice
 
 template<
@@ -94,7 +246,15 @@ template<
 GenericDevice<InputT, OutputT, StateT, EventT>::
 GenericDevice() :
 	pOutputQueue(std::make_shared<Queue<OutputT>>()),
-	pEventQueue(std::make_shared<Queue<Event<EventT>>>())
+	pEventQueue(std::make_shared<Queue<Event<EventT>>>()),
+	pOutputProducer(pOutputQueue->producer()),
+	pEventProducer(pEventQueue->producer()),
+	mInputs(0),
+	mDrops(0),
+	mOutputSupplied(false),
+	mRecordSupplied(false),
+	mDeviceId(0),
+	mEnveloped(false)
 {}
 
 template<
@@ -115,9 +275,45 @@ GenericDevice(
 	mStateFunction(stateFunction),
 	mEventList(eventList),
 	pOutputQueue(std::make_shared<Queue<OutputT>>()),
-	pEventQueue(std::make_shared<Queue<Event<EventT>>>())
+	pEventQueue(std::make_shared<Queue<Event<EventT>>>()),
+	pOutputProducer(pOutputQueue->producer()),
+	pEventProducer(pEventQueue->producer()),
+	mInputs(0),
+	mDrops(0),
+	mOutputSupplied(false),
+	mRecordSupplied(false),
+	mDeviceId(0),
+	mEnveloped(false)
 {}
 
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+GenericDevice<InputT, OutputT, StateT, EventT>::
+GenericDevice(
+		InputDomain inputDomain,
+		OutputDomain outputDomain,
+		InPlaceResolution resolution,
+		StateFunction stateFunction,
+		std::initializer_list<EventFunction> eventList) :
+	GenericDevice(
+			inputDomain,
+			outputDomain,
+			[resolution](InputT input) -> OutputT
+			{
+				OutputT output = OutputT();
+				resolution(input, output);
+
+				return output;
+			},
+			stateFunction,
+			eventList)
+{
+	mInPlaceResolution = std::move(resolution);
+}
+
 template<
 	typename InputT, 
 	typename OutputT, 
@@ -131,7 +327,9 @@ GenericDevice(GenericDevice<InputT, OutputT, StateT, EventT> const& other) :
 			other.mResolutionFunction,
 			other.mStateFunction, 
 			other.mEventList)
-{}
+{
+	mInPlaceResolution = other.mInPlaceResolution;
+}
 
 template<
 	typename InputT, 
@@ -222,7 +420,26 @@ template<
 void GenericDevice<InputT, OutputT, StateT, EventT>::
 connect(GenericDevice<OtherInputT, InputT, OtherStateT, OtherEventT> const& other)
 {
-	mInputConnection = QueueReader<InputT>(other.pOutputQueue);
+	connect(QueueReader<Envelope<InputT>>(other.outputEnvelopeQueue()));
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+template<
+	typename OtherInputT, 
+	typename OtherStateT,
+	typename OtherEventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+connect(GenericDevice<OtherInputT, InputT, OtherStateT, OtherEventT> & other,
+		std::shared_ptr<IQueue<InputT>> link)
+{
+	other.setOutputQueue(link);
+	mInputConnection = QueueReader<InputT>(link);
+	mEnvelopeConnection.disconnect();
+	mEnveloped = false;
 }
 
 template<
@@ -237,6 +454,24 @@ connect(QueueReader<InputT> inputConnection)
 		throw std::invalid_argument("Queue reference expired");
 
 	mInputConnection = std::move(inputConnection);
+	mEnvelopeConnection.disconnect();
+	mEnveloped = false;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+connect(QueueReader<Envelope<InputT>> envelopeConnection)
+{
+	if (envelopeConnection.expired())
+		throw std::invalid_argument("Queue reference expired");
+
+	mEnvelopeConnection = std::move(envelopeConnection);
+	mInputConnection.disconnect();
+	mEnveloped = true;
 }
 
 template<
@@ -261,6 +496,51 @@ connect(QueueReader<Event<EventT>> & eventReader)
 	eventReader.connect(pEventQueue);
 }
 
+template<
+	typename InputT,
+ 	typename OutputT,
+ 	typename StateT,
+ 	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+connect(QueueReader<DeviceRecord> & recordReader)
+{
+	if (!pRecordQueue)
+	{
+		setRecordQueue(std::make_shared<Queue<DeviceRecord>>());
+		mRecordSupplied = false;
+	}
+
+	recordReader.connect(pRecordQueue);
+}
+
+template<
+	typename InputT,
+ 	typename OutputT,
+ 	typename StateT,
+ 	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+connect(QueueReader<OutputEnvelope> & envelopeReader)
+{
+	envelopeReader.connect(outputEnvelopeQueue());
+}
+
+template<
+	typename InputT,
+ 	typename OutputT,
+ 	typename StateT,
+ 	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+connect(QueueReader<EventEnvelope> & envelopeReader)
+{
+	if (!pEventEnvelopeQueue)
+	{
+		pEventEnvelopeQueue = std::make_shared<Queue<EventEnvelope>>();
+		pEventEnvelopeProducer = pEventEnvelopeQueue->producer();
+	}
+
+	envelopeReader.connect(pEventEnvelopeQueue);
+}
+
 template<
 	typename InputT,
 	typename OutputT,
@@ -270,6 +550,8 @@ void GenericDevice<InputT, OutputT, StateT, EventT>::
 disconnect()
 {
 	mInputConnection.disconnect();
+	mEnvelopeConnection.disconnect();
+	mEnveloped = false;
 }
 
 template<
@@ -279,23 +561,245 @@ template<
 	typename EventT>
 bool GenericDevice<InputT, OutputT, StateT, EventT>::
 read(InputT input)
+{
+	return process(input, nullptr);
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+bool GenericDevice<InputT, OutputT, StateT, EventT>::
+read(Envelope<InputT> envelope)
+{
+	return process(envelope.value, &envelope.stamp);
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+bool GenericDevice<InputT, OutputT, StateT, EventT>::
+process(InputT const& input, Stamp const* stamp)
 {
 	if (!mInputDomain(input))
 		return false;
-	
+
+	if (mInPlaceResolution && outputsRead())
+	{
+		if (auto slot = pOutputProducer->claim())
+		{
+			mInPlaceResolution(input, *slot);
+			write(input, stamp, *slot, true);
+
+			return true;
+		}
+	}
+
 	auto output(mResolutionFunction(input));
+	write(input, stamp, output, false);
+
+	return true;
+}
+
+// the device's own queues only count as read while they have readers
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+bool GenericDevice<InputT, OutputT, StateT, EventT>::
+outputsRead() const
+{
+	return mOutputSupplied || pOutputQueue->readers() != 0;
+}
 
-	if (mOutputDomain(output))
-		pOutputQueue->enqueue(output);
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+bool GenericDevice<InputT, OutputT, StateT, EventT>::
+recordsRead() const
+{
+	return pRecordQueue && (mRecordSupplied || pRecordQueue->readers() != 0);
+}
 
+// output is either a claimed slot or moved into the output queue
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+write(InputT const& input, Stamp const* stamp, OutputT & output, bool claimed)
+{
 	auto state(mStateFunction(mCurrentState, input, output));
+	auto sequence = mInputs++;
 
-	for (auto & event : mEventList)
-		pEventQueue->enqueue(event(state)); 
+	// queues without readers are skipped, the state still updates
+	bool const records = recordsRead();
+	bool const events = pEventQueue->readers() != 0;
+
+	mFired.clear();
+
+	if (records || events ||
+			(pEventEnvelopeQueue && pEventEnvelopeQueue->readers() != 0))
+		fire(state, mFired);
+	else
+		track(state);
+
+	if (pOutputEnvelopeQueue || pEventEnvelopeQueue)
+		writeEnvelopes(
+				stamp ? *stamp : Stamp{ monotonicTime(), sequence, mDeviceId },
+				output);
+
+	// copied before the output is moved into its queue
+	if (records)
+	{
+		mRecords.clear();
+
+		if (mOutputDomain(output))
+			mRecords.emplace_back(sequence, output);
+
+		for (auto & event : mFired)
+			mRecords.emplace_back(sequence, event);
+
+		mDrops += mRecords.size() -
+			pRecordProducer->tryEnqueueBulk(mRecords.data(), mRecords.size());
+	}
+
+	// a full queue drops what doesn't fit, the state still updates
+	// an unpublished claimed slot is lent again by the next claim
+	if (outputsRead() && mOutputDomain(output))
+	{
+		if (claimed)
+			pOutputProducer->commit();
+		// moved straight into the slot when the queue lends one
+		else if (auto slot = pOutputProducer->claim())
+		{
+			*slot = std::move(output);
+			pOutputProducer->commit();
+		}
+		else if (!pOutputProducer->tryEnqueue(std::move(output)))
+			++mDrops;
+	}
+
+	if (events && !mFired.empty())
+		mDrops += mFired.size() -
+			pEventProducer->tryEnqueueBulk(mFired.data(), mFired.size());
 
 	mCurrentState = state;
-	
-	return true;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+writeEnvelopes(Stamp const& stamp, OutputT const& output)
+{
+	if (pOutputEnvelopeQueue && pOutputEnvelopeQueue->readers() != 0 &&
+			mOutputDomain(output) &&
+			!pOutputEnvelopeProducer->tryEnqueue(OutputEnvelope{ stamp, output }))
+		++mDrops;
+
+	// fire() already ran for this input if anyone reads the envelopes
+	if (pEventEnvelopeQueue && pEventEnvelopeQueue->readers() != 0)
+		for (auto & event : mFired)
+			if (!pEventEnvelopeProducer->tryEnqueue(EventEnvelope{ stamp, event }))
+				++mDrops;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+std::shared_ptr<IQueue<Envelope<OutputT>>> const&
+GenericDevice<InputT, OutputT, StateT, EventT>::
+outputEnvelopeQueue() const
+{
+	if (!pOutputEnvelopeQueue)
+	{
+		pOutputEnvelopeQueue = std::make_shared<Queue<OutputEnvelope>>();
+		pOutputEnvelopeProducer = pOutputEnvelopeQueue->producer();
+	}
+
+	return pOutputEnvelopeQueue;
+}
+
+// appends the events of the state to fired, except those their Edge
+// triggers hold back
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+fire(StateT const& state, std::vector<Event<EventT>> & fired)
+{
+	for (size_t i = 0; i < mEventList.size(); ++i)
+	{
+		auto event = mEventList[i](state);
+
+		if (i < mEdges.size() && mEdges[i].trigger == Trigger::Edge)
+		{
+			auto & edge = mEdges[i];
+
+			if (edge.fired && edge.last.type() == event.type())
+			{
+				++edge.suppressed;
+				continue;
+			}
+
+			edge.fired = true;
+			edge.last = event;
+		}
+
+		fired.push_back(std::move(event));
+	}
+}
+
+// keeps the Edge triggers current while nobody reads the events, so
+// a reader connecting later only gets changes
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+track(StateT const& state)
+{
+	for (size_t i = 0; i < mEdges.size(); ++i)
+	{
+		if (mEdges[i].trigger != Trigger::Edge)
+			continue;
+
+		mEdges[i].last = mEventList[i](state);
+		mEdges[i].fired = true;
+	}
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+typename GenericDevice<InputT, OutputT, StateT, EventT>::EventEdge &
+GenericDevice<InputT, OutputT, StateT, EventT>::
+edge(size_t eventFunction)
+{
+	if (eventFunction >= mEventList.size())
+		throw std::out_of_range("No such event function");
+
+	if (mEdges.size() < mEventList.size())
+		mEdges.resize(mEventList.size());
+
+	return mEdges[eventFunction];
 }
 
 template<
@@ -306,13 +810,167 @@ template<
 bool GenericDevice<InputT, OutputT, StateT, EventT>::
 read()
 {
-	if (mInputConnection.expired())
-		throw std::runtime_error("No input connected");
+	if (mEnveloped)
+	{
+		auto pinned = mEnvelopeConnection.pin();
+		mEnvelopeBuffer.reserve(1);
+
+		if (mEnvelopeBuffer.fill(pinned, 1) == 0)
+			return false;
 
-	if (mInputConnection.empty())
+		auto & envelope = *mEnvelopeBuffer.data();
+		auto accepted = process(envelope.value, &envelope.stamp);
+		mEnvelopeBuffer.clear();
+
+		return accepted;
+	}
+
+	// throws std::runtime_error if no input is connected
+	auto pinned = mInputConnection.pin();
+	mInputBuffer.reserve(1);
+
+	if (mInputBuffer.fill(pinned, 1) == 0)
 		return false;
 
-	return read(mInputConnection.dequeue());
+	auto accepted = process(*mInputBuffer.data(), nullptr);
+	mInputBuffer.clear();
+
+	return accepted;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+size_t GenericDevice<InputT, OutputT, StateT, EventT>::
+read(InputT const* inputs, size_t count)
+{
+	return process(inputs, nullptr, count);
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+size_t GenericDevice<InputT, OutputT, StateT, EventT>::
+read(Envelope<InputT> const* envelopes, size_t count)
+{
+	return process(nullptr, envelopes, count);
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+size_t GenericDevice<InputT, OutputT, StateT, EventT>::
+process(InputT const* inputs, Envelope<InputT> const* envelopes, size_t count)
+{
+	bool const records = recordsRead();
+	bool const outputs = outputsRead();
+	bool const events = pEventQueue->readers() != 0;
+	bool const eventEnvelopes =
+		pEventEnvelopeQueue && pEventEnvelopeQueue->readers() != 0;
+	size_t accepted = 0;
+
+	mRecords.clear();
+	mOutputBuffer.clear();
+	mEventBuffer.clear();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto const& input = envelopes ? envelopes[i].value : inputs[i];
+
+		if (!mInputDomain(input))
+			continue;
+
+		auto output(mResolutionFunction(input));
+		mCurrentState = mStateFunction(mCurrentState, input, output);
+		auto sequence = mInputs++;
+		++accepted;
+
+		mFired.clear();
+
+		// straight into the event buffer when nothing else needs them
+		if (records || eventEnvelopes)
+			fire(mCurrentState, mFired);
+		else if (events)
+			fire(mCurrentState, mEventBuffer);
+		else
+			track(mCurrentState);
+
+		if (pOutputEnvelopeQueue || pEventEnvelopeQueue)
+			writeEnvelopes(
+					envelopes ?
+						envelopes[i].stamp :
+						Stamp{ monotonicTime(), sequence, mDeviceId },
+					output);
+
+		if (records)
+		{
+			if (mOutputDomain(output))
+				mRecords.emplace_back(sequence, output);
+
+			for (auto & event : mFired)
+				mRecords.emplace_back(sequence, event);
+		}
+
+		if (outputs && mOutputDomain(output))
+			mOutputBuffer.push_back(std::move(output));
+
+		if (events && (records || eventEnvelopes))
+			mEventBuffer.insert(mEventBuffer.end(), mFired.begin(), mFired.end());
+	}
+
+	if (!mRecords.empty())
+		mDrops += mRecords.size() -
+			pRecordProducer->tryEnqueueBulk(mRecords.data(), mRecords.size());
+
+	if (!mOutputBuffer.empty())
+		mDrops += mOutputBuffer.size() -
+			pOutputProducer->tryEnqueueBulk(
+					mOutputBuffer.data(), mOutputBuffer.size());
+
+	if (!mEventBuffer.empty())
+		mDrops += mEventBuffer.size() -
+			pEventProducer->tryEnqueueBulk(
+					mEventBuffer.data(), mEventBuffer.size());
+
+	return accepted;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+size_t GenericDevice<InputT, OutputT, StateT, EventT>::
+pump(size_t max)
+{
+	if (mEnveloped)
+	{
+		auto pinned = mEnvelopeConnection.pin();
+		mEnvelopeBuffer.reserve(max);
+
+		auto count = mEnvelopeBuffer.fill(pinned, max);
+
+		read(mEnvelopeBuffer.data(), count);
+		mEnvelopeBuffer.clear();
+
+		return count;
+	}
+
+	auto pinned = mInputConnection.pin();
+	mInputBuffer.reserve(max);
+
+	auto count = mInputBuffer.fill(pinned, max);
+
+	read(mInputBuffer.data(), count);
+	mInputBuffer.clear();
+
+	return count;
 }
 
 template<
@@ -326,6 +984,114 @@ state()
 	return mCurrentState;
 }
 
+template<
+	typename InputT, 
+	typename OutputT, 
+	typename StateT, 
+	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+setOutputQueue(std::shared_ptr<IQueue<OutputT>> outputQueue)
+{
+	if (!outputQueue)
+		throw std::invalid_argument("Queue reference empty");
+
+	pOutputProducer = outputQueue->producer();
+	pOutputQueue = std::move(outputQueue);
+	mOutputSupplied = true;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+setDeviceId(uint32_t deviceId)
+{
+	mDeviceId = deviceId;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+setTrigger(Trigger trigger)
+{
+	for (size_t i = 0; i < mEventList.size(); ++i)
+		setTrigger(i, trigger);
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+setTrigger(size_t eventFunction, Trigger trigger)
+{
+	auto & eventEdge = edge(eventFunction);
+
+	// the first event after switching is always written
+	eventEdge.trigger = trigger;
+	eventEdge.fired = false;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+size_t GenericDevice<InputT, OutputT, StateT, EventT>::
+suppressed() const
+{
+	size_t count = 0;
+
+	for (auto const& eventEdge : mEdges)
+		count += eventEdge.suppressed;
+
+	return count;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+size_t GenericDevice<InputT, OutputT, StateT, EventT>::
+suppressed(size_t eventFunction) const
+{
+	if (eventFunction >= mEventList.size())
+		throw std::out_of_range("No such event function");
+
+	return eventFunction < mEdges.size() ? mEdges[eventFunction].suppressed : 0;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT>
+size_t GenericDevice<InputT, OutputT, StateT, EventT>::
+drops() const
+{
+	return mDrops;
+}
+
+template<
+	typename InputT, 
+	typename OutputT, 
+	typename StateT, 
+	typename EventT>
+void GenericDevice<InputT, OutputT, StateT, EventT>::
+setRecordQueue(std::shared_ptr<IQueue<DeviceRecord>> recordQueue)
+{
+	pRecordProducer = recordQueue ? recordQueue->producer() : nullptr;
+	pRecordQueue = std::move(recordQueue);
+	mRecordSupplied = true;
+}
+
 template<
 	typename InputT, 
 	typename OutputT, 
@@ -337,6 +1103,7 @@ swap(GenericDevice<InputT, OutputT, StateT, EventT> & other)
 	std::swap(mInputDomain, other.mInputDomain);
 	std::swap(mOutputDomain, other.mOutputDomain);
 	std::swap(mResolutionFunction, other.mResolutionFunction);
+	std::swap(mInPlaceResolution, other.mInPlaceResolution);
 	std::swap(mStateFunction, mStateFunction);
 	std::swap(mEventList, mEventList);
 }
@@ -1,15 +1,111 @@
 #ifndef DOMAIN_H
 #define DOMAIN_H
 
+#include <algorithm>
 #include <functional>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
 
 namespace tamgef {
-namespace device { 
+namespace device {
+
+/// @brief Base of domain expressions, composed with operator+ (union)
+/// and operator* (intersection) into one inlinable predicate.
+/// @details Unlike a composed Domain, which calls each of its terms
+/// through a std::function, an expression is a plain tree of its clauses
+/// that short-circuits like || and &&. Pass it to StaticDevice as is, or
+/// erase it once by constructing a Domain from it.
+template<typename DerivedT>
+class DomainExpression
+{
+public:
+	DerivedT const& derived() const;
+};
+
+/// @brief Leaf of a domain expression, wrapping any predicate.
+template<typename PredicateT>
+class Clause : public DomainExpression<Clause<PredicateT>>
+{
+public:
+	explicit Clause(PredicateT);
+
+	template<typename T>
+	bool operator()(T const&) const;
+
+private:
+	PredicateT mPredicate;
+};
+
+template<typename LeftT, typename RightT>
+class AnyOf : public DomainExpression<AnyOf<LeftT, RightT>>
+{
+public:
+	AnyOf(LeftT, RightT);
+
+	template<typename T>
+	bool operator()(T const&) const;
+
+private:
+	LeftT mLeft;
+	RightT mRight;
+};
+
+template<typename LeftT, typename RightT>
+class AllOf : public DomainExpression<AllOf<LeftT, RightT>>
+{
+public:
+	AllOf(LeftT, RightT);
+
+	template<typename T>
+	bool operator()(T const&) const;
+
+private:
+	LeftT mLeft;
+	RightT mRight;
+};
+
+template<typename PredicateT>
+Clause<PredicateT> clause(PredicateT);
+
+template<typename LeftT, typename RightT>
+AnyOf<LeftT, RightT> operator+(
+		DomainExpression<LeftT> const&,
+		DomainExpression<RightT> const&);
+
+template<typename LeftT, typename RightT>
+AllOf<LeftT, RightT> operator*(
+		DomainExpression<LeftT> const&,
+		DomainExpression<RightT> const&);
 
+/// @brief Set of elements a device accepts, either an arbitrary predicate
+/// or a union of closed intervals.
+/// @details Interval domains of arithmetic types stay intervals under
+/// operator+ (union) and operator* (intersection), kept sorted and
+/// disjoint, and batch tests of float and double run on SSE/AVX. Mixing
+/// in a predicate domain turns the result into a predicate domain, its
+/// terms and operators kept in one flat tree that short-circuits like ||
+/// and &&, operands of the same operator merged into one node.
 template<typename T>
 class Domain
 {
 public:
+	/// @brief Closed interval [lower, upper].
+	struct Interval
+	{
+		T lower;
+		T upper;
+	};
+
 	Domain() = default;
 	Domain(Domain<T> const&);
 	Domain(Domain<T> &&);
@@ -19,73 +115,668 @@ public:
 
 	Domain(std::function<bool(T)>);
 
+	// erases the whole expression once
+	template<typename ExpressionT>
+	Domain(DomainExpression<ExpressionT> const&);
+
+	// throws std::invalid_argument if lower is greater than upper
+	static Domain<T> range(T lower, T upper);
+	static Domain<T> atLeast(T lower);
+	static Domain<T> atMost(T upper);
+
 	bool operator()(T) const;
 	Domain<T> operator+(Domain<T> const&) const;
 	Domain<T> operator*(Domain<T> const&) const;
 
+	// writes whether each element is in the domain to mask
+	// returns the number of elements in the domain
+	size_t test(T const*, size_t, bool* mask) const;
+
+	// true if the domain is a union of intervals
+	bool ranged() const;
+
+	// sorted and disjoint, empty unless ranged
+	std::vector<Interval> const& intervals() const;
+
+	// number of predicates of a predicate domain, 0 if ranged
+	size_t terms() const;
+
 private:
-	std::function<bool(T)> mPredicate;
+	enum class Operation
+	{
+		Term,
+		Any,
+		All
+	};
+
+	struct Node
+	{
+		Operation operation;
+
+		// nodes of the subtree, this one included
+		size_t size;
+
+		// into mTerms, terms only
+		size_t term;
+	};
+
+	// term to test next, or the result
+	struct Step
+	{
+		size_t onTrue;
+		size_t onFalse;
+	};
+
+	static const size_t sAccept = static_cast<size_t>(-1);
+	static const size_t sReject = static_cast<size_t>(-2);
+
+	// each operator node is followed by its operands, e.g. (a + b) * c
+	// is { All, Any, a, b, c }, and a + b + c is { Any, a, b, c }
+	std::vector<Node> mNodes;
+
+	// in the order of the tree, each with the step after it, so a test
+	// runs left to right in one loop, e.g. (a + b) * c jumps from a to c
+	// if a holds, else to b
+	std::vector<std::function<bool(T)>> mTerms;
+	std::vector<Step> mSteps;
+	std::vector<Interval> mIntervals;
+	bool mRanged = false;
+
+	// the interval operations below only compile for arithmetic types,
+	// the std::false_type overloads are never reached
+	typedef std::is_arithmetic<T> Arithmetic;
+
+	explicit Domain(std::vector<Interval>);
+
+	static std::vector<Interval> merge(
+			std::vector<Interval>, std::true_type);
+	static std::vector<Interval> merge(
+			std::vector<Interval>, std::false_type);
+
+	static std::vector<Interval> intersect(
+			std::vector<Interval> const&,
+			std::vector<Interval> const&,
+			std::true_type);
+	static std::vector<Interval> intersect(
+			std::vector<Interval> const&,
+			std::vector<Interval> const&,
+			std::false_type);
+
+	static bool contains(
+			std::vector<Interval> const&, T const&, std::true_type);
+	static bool contains(
+			std::vector<Interval> const&, T const&, std::false_type);
+
+	// the domain as a tree, a ranged one is a single term
+	Domain<T> unranged() const;
+
+	static Domain<T> combine(Operation, Domain<T> const&, Domain<T> const&);
+	void append(Domain<T> const&);
+	void link(size_t node, size_t onTrue, size_t onFalse);
+	size_t firstTerm(size_t node) const;
+	size_t testIntervals(T const*, size_t, bool*) const;
 };
 
+template<typename DerivedT>
+DerivedT const& DomainExpression<DerivedT>::derived() const
+{
+	return static_cast<DerivedT const&>(*this);
+}
+
+template<typename PredicateT>
+Clause<PredicateT>::Clause(PredicateT predicate) :
+	mPredicate(std::move(predicate))
+{}
+
+template<typename PredicateT>
+template<typename T>
+bool Clause<PredicateT>::operator()(T const& element) const
+{
+	return mPredicate(element);
+}
+
+template<typename LeftT, typename RightT>
+AnyOf<LeftT, RightT>::AnyOf(LeftT left, RightT right) :
+	mLeft(std::move(left)),
+	mRight(std::move(right))
+{}
+
+template<typename LeftT, typename RightT>
+template<typename T>
+bool AnyOf<LeftT, RightT>::operator()(T const& element) const
+{
+	return mLeft(element) || mRight(element);
+}
+
+template<typename LeftT, typename RightT>
+AllOf<LeftT, RightT>::AllOf(LeftT left, RightT right) :
+	mLeft(std::move(left)),
+	mRight(std::move(right))
+{}
+
+template<typename LeftT, typename RightT>
+template<typename T>
+bool AllOf<LeftT, RightT>::operator()(T const& element) const
+{
+	return mLeft(element) && mRight(element);
+}
+
+template<typename PredicateT>
+Clause<PredicateT> clause(PredicateT predicate)
+{
+	return Clause<PredicateT>(std::move(predicate));
+}
+
+template<typename LeftT, typename RightT>
+AnyOf<LeftT, RightT> operator+(
+		DomainExpression<LeftT> const& left,
+		DomainExpression<RightT> const& right)
+{
+	return AnyOf<LeftT, RightT>(left.derived(), right.derived());
+}
+
+template<typename LeftT, typename RightT>
+AllOf<LeftT, RightT> operator*(
+		DomainExpression<LeftT> const& left,
+		DomainExpression<RightT> const& right)
+{
+	return AllOf<LeftT, RightT>(left.derived(), right.derived());
+}
+
+template<typename T>
+const size_t Domain<T>::sAccept;
+
+template<typename T>
+const size_t Domain<T>::sReject;
+
 template<typename T>
 Domain<T>::Domain(Domain<T> const& other) :
-	mPredicate(other.mPredicate)
+	mNodes(other.mNodes),
+	mTerms(other.mTerms),
+	mSteps(other.mSteps),
+	mIntervals(other.mIntervals),
+	mRanged(other.mRanged)
 {}
 
 template<typename T>
 Domain<T>::Domain(Domain<T> && other) :
-	mPredicate(std::move(other.mPredicate))
+	mNodes(std::move(other.mNodes)),
+	mTerms(std::move(other.mTerms)),
+	mSteps(std::move(other.mSteps)),
+	mIntervals(std::move(other.mIntervals)),
+	mRanged(other.mRanged)
 {}
 
 template<typename T>
 Domain<T> Domain<T>::operator=(Domain<T> const& other)
 {
-	mPredicate = other.mPredicate;
+	mNodes = other.mNodes;
+	mTerms = other.mTerms;
+	mSteps = other.mSteps;
+	mIntervals = other.mIntervals;
+	mRanged = other.mRanged;
 	return *this;
 }
 
 template<typename T>
 Domain<T> Domain<T>::operator=(Domain<T> && other)
 {
-	mPredicate = std::move(other.mPredicate);
+	mNodes = std::move(other.mNodes);
+	mTerms = std::move(other.mTerms);
+	mSteps = std::move(other.mSteps);
+	mIntervals = std::move(other.mIntervals);
+	mRanged = other.mRanged;
 	return *this;
 }
 
 template<typename T>
 Domain<T>::Domain(std::function<bool(T)> predicate) :
-	mPredicate(predicate)
+	mNodes{ Node{ Operation::Term, 1, 0 } },
+	mTerms{ std::move(predicate) },
+	mSteps{ Step{ sAccept, sReject } }
+{}
+
+template<typename T>
+template<typename ExpressionT>
+Domain<T>::Domain(DomainExpression<ExpressionT> const& expression) :
+	mNodes{ Node{ Operation::Term, 1, 0 } },
+	mTerms{ std::function<bool(T)>(expression.derived()) },
+	mSteps{ Step{ sAccept, sReject } }
+{}
+
+template<typename T>
+Domain<T>::Domain(std::vector<Interval> intervals) :
+	mIntervals(merge(std::move(intervals), Arithmetic())),
+	mRanged(true)
 {}
 
+template<typename T>
+Domain<T> Domain<T>::range(T lower, T upper)
+{
+	static_assert(std::is_arithmetic<T>::value,
+			"Interval domains need an arithmetic element type");
+
+	if (upper < lower)
+		throw std::invalid_argument("Empty interval");
+
+	return Domain<T>(std::vector<Interval>{ Interval{ lower, upper } });
+}
+
+template<typename T>
+Domain<T> Domain<T>::atLeast(T lower)
+{
+	return range(lower, std::numeric_limits<T>::has_infinity ?
+			std::numeric_limits<T>::infinity() :
+			std::numeric_limits<T>::max());
+}
+
+template<typename T>
+Domain<T> Domain<T>::atMost(T upper)
+{
+	return range(std::numeric_limits<T>::has_infinity ?
+			-std::numeric_limits<T>::infinity() :
+			std::numeric_limits<T>::lowest(), upper);
+}
+
 template<typename T>
 bool Domain<T>::operator()(T element) const
 {
-	return mPredicate(element);
+	if (mRanged)
+		return contains(mIntervals, element, Arithmetic());
+
+	// like calling an empty std::function
+	if (mNodes.empty())
+		throw std::bad_function_call();
+
+	size_t term = 0;
+
+	while (term < mTerms.size())
+		term = mTerms[term](element) ?
+			mSteps[term].onTrue :
+			mSteps[term].onFalse;
+
+	return term == sAccept;
 }
 
 template<typename T>
 Domain<T> Domain<T>::operator+(Domain<T> const& other) const
 {
-	Domain<T> compositeDomain(
-			[=](T const& element) -> bool
-			{
-				return mPredicate(element) || other.mPredicate(element);
-			});
+	if (mRanged && other.mRanged)
+	{
+		auto intervals = mIntervals;
+		intervals.insert(intervals.end(),
+				other.mIntervals.begin(), other.mIntervals.end());
 
-	return compositeDomain;
+		return Domain<T>(std::move(intervals));
+	}
+
+	return combine(Operation::Any, *this, other);
 }
 
 template<typename T>
 Domain<T> Domain<T>::operator*(Domain<T> const& other) const
 {
-	Domain<T> compositeDomain(
-			[=](T const& element) -> bool
+	if (mRanged && other.mRanged)
+	{
+		auto intervals = intersect(mIntervals, other.mIntervals, Arithmetic());
+
+		return Domain<T>(std::move(intervals));
+	}
+
+	return combine(Operation::All, *this, other);
+}
+
+template<typename T>
+size_t Domain<T>::test(T const* elements, size_t count, bool* mask) const
+{
+	if (mRanged)
+		return testIntervals(elements, count, mask);
+
+	size_t accepted = 0;
+
+	for (size_t i = 0; i < count; ++i)
+		accepted += (mask[i] = (*this)(elements[i]));
+
+	return accepted;
+}
+
+template<typename T>
+bool Domain<T>::ranged() const
+{
+	return mRanged;
+}
+
+template<typename T>
+std::vector<typename Domain<T>::Interval> const& Domain<T>::intervals() const
+{
+	return mIntervals;
+}
+
+template<typename T>
+size_t Domain<T>::terms() const
+{
+	return mTerms.size();
+}
+
+// sorts the intervals and merges overlapping ones
+template<typename T>
+std::vector<typename Domain<T>::Interval> Domain<T>::merge(
+		std::vector<Interval> intervals, std::true_type)
+{
+	std::vector<Interval> merged;
+
+	std::sort(intervals.begin(), intervals.end(),
+			[](Interval const& a, Interval const& b) -> bool
 			{
-				return mPredicate(element) && other.mPredicate(element);
+				return a.lower < b.lower;
 			});
 
+	for (auto const& interval : intervals)
+	{
+		if (!merged.empty() && !(merged.back().upper < interval.lower))
+			merged.back().upper = std::max(merged.back().upper, interval.upper);
+		else
+			merged.push_back(interval);
+	}
+
+	return merged;
+}
+
+template<typename T>
+std::vector<typename Domain<T>::Interval> Domain<T>::merge(
+		std::vector<Interval>, std::false_type)
+{
+	return std::vector<Interval>();
+}
+
+// both lists are sorted and disjoint, so walks them together
+template<typename T>
+std::vector<typename Domain<T>::Interval> Domain<T>::intersect(
+		std::vector<Interval> const& intervals,
+		std::vector<Interval> const& otherIntervals,
+		std::true_type)
+{
+	std::vector<Interval> intersection;
+	auto a = intervals.begin();
+	auto b = otherIntervals.begin();
+
+	while (a != intervals.end() && b != otherIntervals.end())
+	{
+		auto lower = std::max(a->lower, b->lower);
+		auto upper = std::min(a->upper, b->upper);
+
+		if (!(upper < lower))
+			intersection.push_back(Interval{ lower, upper });
+
+		if (a->upper < b->upper)
+			++a;
+		else
+			++b;
+	}
+
+	return intersection;
+}
+
+template<typename T>
+std::vector<typename Domain<T>::Interval> Domain<T>::intersect(
+		std::vector<Interval> const&,
+		std::vector<Interval> const&,
+		std::false_type)
+{
+	return std::vector<Interval>();
+}
+
+template<typename T>
+bool Domain<T>::contains(
+		std::vector<Interval> const& intervals,
+		T const& element,
+		std::true_type)
+{
+	// NaN is in no interval
+	for (auto const& interval : intervals)
+		if (interval.lower <= element && element <= interval.upper)
+			return true;
+
+	return false;
+}
+
+template<typename T>
+bool Domain<T>::contains(
+		std::vector<Interval> const&, T const&, std::false_type)
+{
+	return false;
+}
+
+template<typename T>
+Domain<T> Domain<T>::unranged() const
+{
+	if (!mRanged)
+		return *this;
+
+	auto intervals = mIntervals;
+
+	return Domain<T>([intervals](T element) -> bool
+	{
+		return contains(intervals, element, Arithmetic());
+	});
+}
+
+template<typename T>
+Domain<T> Domain<T>::combine(
+		Operation operation,
+		Domain<T> const& domain,
+		Domain<T> const& other)
+{
+	Domain<T> compositeDomain;
+
+	compositeDomain.mNodes.push_back(Node{ operation, 1, 0 });
+	compositeDomain.append(domain.unranged());
+	compositeDomain.append(other.unranged());
+
+	compositeDomain.mSteps.resize(compositeDomain.mTerms.size());
+	compositeDomain.link(0, sAccept, sReject);
+
 	return compositeDomain;
 }
 
+// appends the operand to the root, merging an operand of the same
+// operator into it
+template<typename T>
+void Domain<T>::append(Domain<T> const& operand)
+{
+	auto & root = mNodes.front();
+	auto offset = mTerms.size();
+
+	// an empty operand throws when evaluated, like an empty std::function
+	if (operand.mNodes.empty())
+	{
+		mTerms.emplace_back();
+		mNodes.push_back(Node{ Operation::Term, 1, offset });
+		++mNodes.front().size;
+
+		return;
+	}
+
+	size_t first = operand.mNodes.front().operation == root.operation ? 1 : 0;
+
+	root.size += operand.mNodes.size() - first;
+	mTerms.insert(mTerms.end(), operand.mTerms.begin(), operand.mTerms.end());
+
+	for (auto node = operand.mNodes.begin() + first;
+			node != operand.mNodes.end(); ++node)
+	{
+		mNodes.push_back(*node);
+		mNodes.back().term += offset;
+	}
+}
+
+// sets the steps of the subtree's terms, an operand deciding the result
+// jumps to onTrue or onFalse, the others to the next operand
+template<typename T>
+void Domain<T>::link(size_t node, size_t onTrue, size_t onFalse)
+{
+	auto const& current = mNodes[node];
+
+	if (current.operation == Operation::Term)
+	{
+		mSteps[current.term] = Step{ onTrue, onFalse };
+		return;
+	}
+
+	auto end = node + current.size;
+	auto operand = node + 1;
+
+	for (auto next = operand + mNodes[operand].size; next != end;
+			operand = next, next += mNodes[next].size)
+	{
+		if (current.operation == Operation::Any)
+			link(operand, onTrue, firstTerm(next));
+		else
+			link(operand, firstTerm(next), onFalse);
+	}
+
+	link(operand, onTrue, onFalse);
+}
+
+template<typename T>
+size_t Domain<T>::firstTerm(size_t node) const
+{
+	while (mNodes[node].operation != Operation::Term)
+		++node;
+
+	return mNodes[node].term;
+}
+
+// scalar fallback, float and double have vectorized specializations
+template<typename T>
+size_t Domain<T>::testIntervals(T const* elements, size_t count, bool* mask) const
+{
+	size_t accepted = 0;
+
+	for (size_t i = 0; i < count; ++i)
+		accepted += (mask[i] = contains(mIntervals, elements[i], Arithmetic()));
+
+	return accepted;
+}
+
+#if defined(__AVX__)
+
+template<>
+inline size_t Domain<double>::testIntervals(
+		double const* elements, size_t count, bool* mask) const
+{
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		auto values = _mm256_loadu_pd(elements + i);
+		auto in = _mm256_setzero_pd();
+
+		for (auto const& interval : mIntervals)
+			in = _mm256_or_pd(in, _mm256_and_pd(
+					_mm256_cmp_pd(values, _mm256_set1_pd(interval.lower), _CMP_GE_OQ),
+					_mm256_cmp_pd(values, _mm256_set1_pd(interval.upper), _CMP_LE_OQ)));
+
+		auto bits = _mm256_movemask_pd(in);
+
+		for (int lane = 0; lane < 4; ++lane)
+			mask[i + lane] = (bits >> lane) & 1;
+	}
+
+	for (; i < count; ++i)
+		mask[i] = contains(mIntervals, elements[i], Arithmetic());
+
+	return std::count(mask, mask + count, true);
+}
+
+template<>
+inline size_t Domain<float>::testIntervals(
+		float const* elements, size_t count, bool* mask) const
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		auto values = _mm256_loadu_ps(elements + i);
+		auto in = _mm256_setzero_ps();
+
+		for (auto const& interval : mIntervals)
+			in = _mm256_or_ps(in, _mm256_and_ps(
+					_mm256_cmp_ps(values, _mm256_set1_ps(interval.lower), _CMP_GE_OQ),
+					_mm256_cmp_ps(values, _mm256_set1_ps(interval.upper), _CMP_LE_OQ)));
+
+		auto bits = _mm256_movemask_ps(in);
+
+		for (int lane = 0; lane < 8; ++lane)
+			mask[i + lane] = (bits >> lane) & 1;
+	}
+
+	for (; i < count; ++i)
+		mask[i] = contains(mIntervals, elements[i], Arithmetic());
+
+	return std::count(mask, mask + count, true);
+}
+
+#elif defined(__SSE2__)
+
+template<>
+inline size_t Domain<double>::testIntervals(
+		double const* elements, size_t count, bool* mask) const
+{
+	size_t i = 0;
+
+	for (; i + 2 <= count; i += 2)
+	{
+		auto values = _mm_loadu_pd(elements + i);
+		auto in = _mm_setzero_pd();
+
+		for (auto const& interval : mIntervals)
+			in = _mm_or_pd(in, _mm_and_pd(
+					_mm_cmpge_pd(values, _mm_set1_pd(interval.lower)),
+					_mm_cmple_pd(values, _mm_set1_pd(interval.upper))));
+
+		auto bits = _mm_movemask_pd(in);
+
+		mask[i] = bits & 1;
+		mask[i + 1] = (bits >> 1) & 1;
+	}
+
+	for (; i < count; ++i)
+		mask[i] = contains(mIntervals, elements[i], Arithmetic());
+
+	return std::count(mask, mask + count, true);
+}
+
+template<>
+inline size_t Domain<float>::testIntervals(
+		float const* elements, size_t count, bool* mask) const
+{
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		auto values = _mm_loadu_ps(elements + i);
+		auto in = _mm_setzero_ps();
+
+		for (auto const& interval : mIntervals)
+			in = _mm_or_ps(in, _mm_and_ps(
+					_mm_cmpge_ps(values, _mm_set1_ps(interval.lower)),
+					_mm_cmple_ps(values, _mm_set1_ps(interval.upper))));
+
+		auto bits = _mm_movemask_ps(in);
+
+		for (int lane = 0; lane < 4; ++lane)
+			mask[i + lane] = (bits >> lane) & 1;
+	}
+
+	for (; i < count; ++i)
+		mask[i] = contains(mIntervals, elements[i], Arithmetic());
+
+	return std::count(mask, mask + count, true);
+}
+
+#endif
+
 } // namespace device
 } // namespace tamgef
 
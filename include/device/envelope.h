@@ -0,0 +1,31 @@
+#ifndef ENVELOPE_H
+#define ENVELOPE_H
+
+#include <cstdint>
+
+namespace tamgef {
+namespace device {
+
+/// @brief Origin of a sample, set once by the device that first read it.
+/// @details timestamp is monotonicTime() at the source, so the latency
+/// at any later hop is monotonicTime() - timestamp. sequence counts the
+/// source device's inputs, device is its id from setDeviceId().
+struct Stamp
+{
+	uint64_t timestamp;
+	uint64_t sequence;
+	uint32_t device;
+};
+
+/// @brief Output, event or input carrying the Stamp of its source.
+template<typename T>
+struct Envelope
+{
+	Stamp stamp;
+	T value;
+};
+
+} // namespace device
+} // namespace tamgef
+
+#endif
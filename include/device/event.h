@@ -3,15 +3,106 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <initializer_list>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <typeinfo>
 #include <typeindex>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace tamgef {
 namespace device {
 
+// true if std::hash<T> can hash a T
+template<typename T>
+class Hashable
+{
+	template<typename U>
+	static auto check(int) -> decltype(
+			std::hash<U>()(std::declval<U const&>()), std::true_type());
+
+	template<typename>
+	static std::false_type check(...);
+
+public:
+	static const bool value = decltype(check<T>(0))::value;
+};
+
+/// @brief Registered event types, appended by one writer at a time
+/// while any number of threads look them up without locking.
+/// @details Each type is a node hashed into a fixed array of buckets and
+/// linked in registration order, nothing is copied or freed before the
+/// set is. Enums hash their underlying value; types std::hash can't hash
+/// share one bucket, searched linearly with ==.
+template<typename T>
+class EventTypeSet
+{
+public:
+	// constant, so a static set is ready before any constructor runs
+	constexpr EventTypeSet();
+	EventTypeSet(EventTypeSet<T> const&) = delete;
+	~EventTypeSet();
+
+	// callers serialize inserts, duplicates are ignored
+	// returns false for a duplicate
+	bool insert(T const&);
+	bool contains(T const&) const;
+
+	// in registration order
+	std::vector<T> types() const;
+
+private:
+	struct Node
+	{
+		Node(T const&, Node* bucketNext);
+
+		T type;
+		Node* const bucketNext;
+		std::atomic<Node*> next;
+	};
+
+	static const size_t sBuckets = 1024;
+
+	typedef std::integral_constant<int,
+			std::is_enum<T>::value ? 0 : Hashable<T>::value ? 1 : 2> Lookup;
+
+	std::atomic<Node*> mBuckets[sBuckets];
+	std::atomic<Node*> mFirst;
+
+	// only touched by inserts
+	Node* mLast;
+
+	static size_t bucket(T const&, std::integral_constant<int, 0>);
+	static size_t bucket(T const&, std::integral_constant<int, 1>);
+	static size_t bucket(T const&, std::integral_constant<int, 2>);
+};
+
+// nanoseconds on the steady clock, for event and sample timestamps
+inline uint64_t monotonicTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// @brief Trivially copyable event of an enum type, for bulk queue
+/// transfers, SharedMemoryQueue and binary recording.
+/// @details Holds what Event does plus a monotonicTime() timestamp, in
+/// 16 bytes. Convert with Event::record() and Event(EventRecord const&).
+template<typename T>
+struct EventRecord
+{
+	uint64_t timestamp;
+	T type;
+	bool flag;
+};
+
 template<typename T>
 class Event
 {
@@ -23,10 +114,14 @@ public:
 	virtual ~Event() = default;
 
 	// throws std::invalid_argument if typeID has not been registered
+	// copies and moves of an event aren't checked again
 	Event(T const&);
 
-	// adds new event type to static list of types
-	// returns false if type is duplicate, otherwise true
+	// throws std::invalid_argument if the record's type isn't registered
+	explicit Event(EventRecord<T> const&);
+
+	// adds new event type to static list of types, duplicates are ignored
+	// safe while other threads construct events
 	static void registerType(T const&);
 
 	static void registerType(std::initializer_list<T> const&);
@@ -43,19 +138,128 @@ public:
 	// sets event flag to true, indicating event is to be processed
 	void raise();
 
+	// returns true while the event is to be processed
+	bool raised() const;
+
 	// returns type id of event
 	T type() const;
 
+	// stamped with the current monotonicTime()
+	EventRecord<T> record() const;
+
 	void swap(Event<T> &);
 
 private:
-	static std::vector<T> sRegisteredTypes;
+	// lookups never lock, registrations are serialized by the mutex
+	static EventTypeSet<T> sTypes;
+	static std::mutex sRegistryMutex;
+
+	static void registerTypes(T const* first, T const* last);
 
 	bool mFlag;
 	T mType;
 };
 
-template<typename T> std::vector<T> Event<T>::sRegisteredTypes;
+template<typename T>
+const size_t EventTypeSet<T>::sBuckets;
+
+template<typename T>
+constexpr EventTypeSet<T>::EventTypeSet() :
+	mBuckets(),
+	mFirst(nullptr),
+	mLast(nullptr)
+{}
+
+template<typename T>
+EventTypeSet<T>::~EventTypeSet()
+{
+	auto node = mFirst.load(std::memory_order_relaxed);
+
+	while (node)
+	{
+		auto next = node->next.load(std::memory_order_relaxed);
+		delete node;
+		node = next;
+	}
+}
+
+template<typename T>
+EventTypeSet<T>::Node::Node(T const& type, Node* bucketNext) :
+	type(type),
+	bucketNext(bucketNext),
+	next(nullptr)
+{}
+
+template<typename T>
+bool EventTypeSet<T>::insert(T const& type)
+{
+	if (contains(type))
+		return false;
+
+	auto & head = mBuckets[bucket(type, Lookup())];
+	auto node = new Node(type, head.load(std::memory_order_relaxed));
+
+	// published complete, a lookup sees the whole node or none of it
+	head.store(node, std::memory_order_release);
+
+	if (mLast)
+		mLast->next.store(node, std::memory_order_release);
+	else
+		mFirst.store(node, std::memory_order_release);
+
+	mLast = node;
+
+	return true;
+}
+
+template<typename T>
+bool EventTypeSet<T>::contains(T const& type) const
+{
+	auto node = mBuckets[bucket(type, Lookup())].load(std::memory_order_acquire);
+
+	for (; node; node = node->bucketNext)
+		if (node->type == type)
+			return true;
+
+	return false;
+}
+
+template<typename T>
+std::vector<T> EventTypeSet<T>::types() const
+{
+	std::vector<T> types;
+
+	for (auto node = mFirst.load(std::memory_order_acquire); node;
+			node = node->next.load(std::memory_order_acquire))
+		types.push_back(node->type);
+
+	return types;
+}
+
+template<typename T>
+size_t EventTypeSet<T>::bucket(T const& type, std::integral_constant<int, 0>)
+{
+	typedef typename std::underlying_type<T>::type Underlying;
+
+	return std::hash<Underlying>()(static_cast<Underlying>(type)) % sBuckets;
+}
+
+template<typename T>
+size_t EventTypeSet<T>::bucket(T const& type, std::integral_constant<int, 1>)
+{
+	return std::hash<T>()(type) % sBuckets;
+}
+
+template<typename T>
+size_t EventTypeSet<T>::bucket(T const&, std::integral_constant<int, 2>)
+{
+	return 0;
+}
+
+template<typename T>
+EventTypeSet<T> Event<T>::sTypes;
+
+template<typename T> std::mutex Event<T>::sRegistryMutex;
 
 template<typename T>
 Event<T>::Event() :
@@ -71,14 +275,26 @@ Event<T>::Event(T const& type) :
 		throw std::invalid_argument("Unregistered type");
 }
 
+template<typename T>
+Event<T>::Event(EventRecord<T> const& record) :
+	Event(record.type)
+{
+	static_assert(std::is_enum<T>::value && sizeof(T) <= 4,
+			"Event records need an enum type of at most 32 bits");
+
+	mFlag = record.flag;
+}
+
 template<typename T>
 Event<T>::Event(Event<T> const& other) :
-	Event(other.mType)
+	mFlag(other.mFlag),
+	mType(other.mType)
 {}
 
 template<typename T>
 Event<T>::Event(Event<T> && other) :
-	Event(std::move(other.mType))
+	mFlag(other.mFlag),
+	mType(std::move(other.mType))
 {}
 
 template<typename T>
@@ -91,33 +307,34 @@ Event<T> & Event<T>::operator=(Event<T> other)
 template<typename T>
 void Event<T>::registerType(T const& type)
 {
-	if (!registered(type))
-		sRegisteredTypes.push_back(type);
+	registerTypes(&type, &type + 1);
 }
 
 template<typename T>
 void Event<T>::registerType(std::initializer_list<T> const& types)
 {
-	for (auto & type : types) 
-		registerType(type);
+	registerTypes(types.begin(), types.end());
 }
 
 template<typename T>
 std::vector<T> Event<T>::registeredTypes()
 {
-	return sRegisteredTypes;
+	return sTypes.types();
 }
 
 template<typename T>
 bool Event<T>::registered(T const& type)
 {
-	auto iType = std::find(sRegisteredTypes.begin(),
-			sRegisteredTypes.end(), type);
+	return sTypes.contains(type);
+}
 
-	if (iType == sRegisteredTypes.end())
-		return false;
+template<typename T>
+void Event<T>::registerTypes(T const* first, T const* last)
+{
+	std::lock_guard<std::mutex> lock(sRegistryMutex);
 
-	return true;
+	for (; first != last; ++first)
+		sTypes.insert(*first);
 }
 
 template<typename T>
@@ -132,6 +349,26 @@ void Event<T>::lower()
 	mFlag = false;
 }
 
+template<typename T>
+bool Event<T>::raised() const
+{
+	return mFlag;
+}
+
+template<typename T>
+EventRecord<T> Event<T>::record() const
+{
+	static_assert(std::is_enum<T>::value && sizeof(T) <= 4,
+			"Event records need an enum type of at most 32 bits");
+
+	EventRecord<T> record;
+	record.timestamp = monotonicTime();
+	record.type = mType;
+	record.flag = mFlag;
+
+	return record;
+}
+
 template<typename T>
 T Event<T>::type() const
 {
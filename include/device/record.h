@@ -0,0 +1,182 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include <device/event.h>
+
+namespace tamgef {
+namespace device {
+
+/// @brief Entry of a device's merged stream, either an output or an
+/// event, tagged with the input that produced it.
+/// @details Records of one input are enqueued together, output first,
+/// so a reader sees them contiguously and in input order.
+template<typename OutputT, typename EventT>
+class Record
+{
+public:
+	enum class Kind : uint8_t
+	{
+		Output,
+		Event
+	};
+
+	Record();
+	Record(Record<OutputT, EventT> const&);
+	Record(Record<OutputT, EventT> &&);
+	Record<OutputT, EventT> & operator=(Record<OutputT, EventT>);
+	~Record();
+
+	Record(uint64_t input, OutputT const&);
+	Record(uint64_t input, Event<EventT> const&);
+
+	// sequence number of the input within its device
+	uint64_t input() const;
+	Kind kind() const;
+
+	// throw std::logic_error if the record holds the other kind
+	OutputT const& output() const;
+	Event<EventT> const& event() const;
+
+	void swap(Record<OutputT, EventT> &);
+
+private:
+	Kind mKind;
+	uint64_t mInput;
+
+	union
+	{
+		OutputT mOutput;
+		Event<EventT> mEvent;
+	};
+};
+
+template<typename OutputT, typename EventT>
+Record<OutputT, EventT>::Record() :
+	mKind(Kind::Output),
+	mInput(0)
+{
+	new (&mOutput) OutputT();
+}
+
+template<typename OutputT, typename EventT>
+Record<OutputT, EventT>::Record(Record<OutputT, EventT> const& other) :
+	mKind(other.mKind),
+	mInput(other.mInput)
+{
+	if (mKind == Kind::Output)
+		new (&mOutput) OutputT(other.mOutput);
+	else
+		new (&mEvent) Event<EventT>(other.mEvent);
+}
+
+template<typename OutputT, typename EventT>
+Record<OutputT, EventT>::Record(Record<OutputT, EventT> && other) :
+	mKind(other.mKind),
+	mInput(other.mInput)
+{
+	if (mKind == Kind::Output)
+		new (&mOutput) OutputT(std::move(other.mOutput));
+	else
+		new (&mEvent) Event<EventT>(std::move(other.mEvent));
+}
+
+template<typename OutputT, typename EventT>
+Record<OutputT, EventT> & Record<OutputT, EventT>::
+operator=(Record<OutputT, EventT> other)
+{
+	swap(other);
+	return *this;
+}
+
+template<typename OutputT, typename EventT>
+Record<OutputT, EventT>::~Record()
+{
+	if (mKind == Kind::Output)
+		mOutput.~OutputT();
+	else
+		mEvent.~Event<EventT>();
+}
+
+template<typename OutputT, typename EventT>
+Record<OutputT, EventT>::Record(uint64_t input, OutputT const& output) :
+	mKind(Kind::Output),
+	mInput(input)
+{
+	new (&mOutput) OutputT(output);
+}
+
+template<typename OutputT, typename EventT>
+Record<OutputT, EventT>::Record(uint64_t input, Event<EventT> const& event) :
+	mKind(Kind::Event),
+	mInput(input)
+{
+	new (&mEvent) Event<EventT>(event);
+}
+
+template<typename OutputT, typename EventT>
+uint64_t Record<OutputT, EventT>::input() const
+{
+	return mInput;
+}
+
+template<typename OutputT, typename EventT>
+typename Record<OutputT, EventT>::Kind Record<OutputT, EventT>::kind() const
+{
+	return mKind;
+}
+
+template<typename OutputT, typename EventT>
+OutputT const& Record<OutputT, EventT>::output() const
+{
+	if (mKind != Kind::Output)
+		throw std::logic_error("Record holds an event");
+
+	return mOutput;
+}
+
+template<typename OutputT, typename EventT>
+Event<EventT> const& Record<OutputT, EventT>::event() const
+{
+	if (mKind != Kind::Event)
+		throw std::logic_error("Record holds an output");
+
+	return mEvent;
+}
+
+template<typename OutputT, typename EventT>
+void Record<OutputT, EventT>::swap(Record<OutputT, EventT> & other)
+{
+	if (mKind == other.mKind)
+	{
+		if (mKind == Kind::Output)
+			std::swap(mOutput, other.mOutput);
+		else
+			mEvent.swap(other.mEvent);
+
+		std::swap(mInput, other.mInput);
+		return;
+	}
+
+	auto & outputRecord = mKind == Kind::Output ? *this : other;
+	auto & eventRecord = mKind == Kind::Output ? other : *this;
+
+	OutputT output(std::move(outputRecord.mOutput));
+	outputRecord.mOutput.~OutputT();
+	new (&outputRecord.mEvent) Event<EventT>(std::move(eventRecord.mEvent));
+
+	eventRecord.mEvent.~Event<EventT>();
+	new (&eventRecord.mOutput) OutputT(std::move(output));
+
+	std::swap(mKind, other.mKind);
+	std::swap(mInput, other.mInput);
+}
+
+} // namespace device
+} // namespace tamgef
+
+#endif
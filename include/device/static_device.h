@@ -0,0 +1,563 @@
+#ifndef STATIC_DEVICE_H
+#define STATIC_DEVICE_H
+
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <device/event.h>
+#include <queue/element_buffer.h>
+#include <queue/iqueue.h>
+#include <queue/queue.h>
+#include <queue/queue_reader.h>
+
+namespace tamgef {
+namespace device {
+
+using namespace tamgef::queue;
+
+/// @brief Whether a resolution stage writes into the output it's given,
+/// i.e. is callable as void(InputT, OutputT &).
+template<typename ResolutionT, typename InputT, typename OutputT>
+struct ResolvesInPlace
+{
+private:
+	template<typename F>
+	static auto test(int) -> decltype(
+			std::declval<F &>()(
+				std::declval<InputT const&>(), std::declval<OutputT &>()),
+			std::true_type());
+
+	template<typename>
+	static std::false_type test(...);
+
+public:
+	static const bool value = decltype(test<ResolutionT>(0))::value;
+};
+
+/// @brief Device whose stages are known at compile time.
+/// @details Works like GenericDevice, but stores each stage as its own
+/// callable type instead of a std::function, so a read can be inlined
+/// from input domain to the last event. Event functions return an
+/// Event<EventT> or an EventT. A resolution stage taking the output by
+/// reference writes it straight into a slot lent by the output queue.
+/// Build one with makeStaticDevice().
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+class StaticDevice
+{
+public:
+	StaticDevice(
+			InputDomainT,
+			OutputDomainT,
+			ResolutionT,
+			StateFunctionT,
+			EventFunctionTs...);
+
+	StaticDevice(StaticDevice const&) = delete;
+	StaticDevice(StaticDevice &&) = default;
+	virtual ~StaticDevice() = default;
+
+	// reads the other device's outputs
+	template<typename OtherDeviceT>
+	void connect(OtherDeviceT &);
+
+	void connect(QueueReader<InputT>);
+	void connect(QueueReader<OutputT> &);
+	void connect(QueueReader<Event<EventT>> &);
+	void disconnect();
+
+	bool read();
+	bool read(InputT);
+	StateT state();
+
+	// number of outputs and events dropped because their queue was full
+	size_t drops() const;
+
+	// always written, the queue may be read out of process or directly,
+	// only the device's own queues are skipped while nobody reads them
+	void setOutputQueue(std::shared_ptr<IQueue<OutputT>>);
+
+private:
+	std::shared_ptr<IQueue<OutputT>> pOutputQueue;
+	std::shared_ptr<IQueue<Event<EventT>>> pEventQueue;
+	std::unique_ptr<typename IQueue<OutputT>::Producer> pOutputProducer;
+	std::unique_ptr<typename IQueue<Event<EventT>>::Producer> pEventProducer;
+
+	InputDomainT mInputDomain;
+	OutputDomainT mOutputDomain;
+	ResolutionT mResolutionFunction;
+	StateFunctionT mStateFunction;
+	std::tuple<EventFunctionTs...> mEventFunctions;
+	QueueReader<InputT> mInputConnection;
+	ElementBuffer<InputT> mInputBuffer;
+	StateT mCurrentState;
+	size_t mDrops;
+	bool mOutputSupplied;
+
+	typedef std::integral_constant<bool,
+			ResolvesInPlace<ResolutionT, InputT, OutputT>::value> InPlace;
+
+	void resolve(InputT const&, std::true_type);
+	void resolve(InputT const&, std::false_type);
+	void write(InputT const&, OutputT & output, bool claimed);
+
+	template<size_t I>
+	typename std::enable_if<I == sizeof...(EventFunctionTs)>::type
+	emit(StateT const&);
+
+	template<size_t I>
+	typename std::enable_if<I < sizeof...(EventFunctionTs)>::type
+	emit(StateT const&);
+};
+
+/// @brief Builds a StaticDevice, deducing the stage types.
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>
+makeStaticDevice(
+		InputDomainT inputDomain,
+		OutputDomainT outputDomain,
+		ResolutionT resolutionFunction,
+		StateFunctionT stateFunction,
+		EventFunctionTs... eventFunctions)
+{
+	return StaticDevice<
+		InputT, OutputT, StateT, EventT,
+		InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+		EventFunctionTs...>(
+			std::move(inputDomain),
+			std::move(outputDomain),
+			std::move(resolutionFunction),
+			std::move(stateFunction),
+			std::move(eventFunctions)...);
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+StaticDevice(
+		InputDomainT inputDomain,
+		OutputDomainT outputDomain,
+		ResolutionT resolutionFunction,
+		StateFunctionT stateFunction,
+		EventFunctionTs... eventFunctions) :
+	pOutputQueue(std::make_shared<Queue<OutputT>>()),
+	pEventQueue(std::make_shared<Queue<Event<EventT>>>()),
+	pOutputProducer(pOutputQueue->producer()),
+	pEventProducer(pEventQueue->producer()),
+	mInputDomain(std::move(inputDomain)),
+	mOutputDomain(std::move(outputDomain)),
+	mResolutionFunction(std::move(resolutionFunction)),
+	mStateFunction(std::move(stateFunction)),
+	mEventFunctions(std::move(eventFunctions)...),
+	mDrops(0),
+	mOutputSupplied(false)
+{}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+template<typename OtherDeviceT>
+void
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+connect(OtherDeviceT & other)
+{
+	QueueReader<InputT> inputConnection;
+
+	other.connect(inputConnection);
+	connect(std::move(inputConnection));
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+void
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+connect(QueueReader<InputT> inputConnection)
+{
+	if (inputConnection.expired())
+		throw std::invalid_argument("Queue reference expired");
+
+	mInputConnection = std::move(inputConnection);
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+void
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+connect(QueueReader<OutputT> & outputReader)
+{
+	outputReader.connect(pOutputQueue);
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+void
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+connect(QueueReader<Event<EventT>> & eventReader)
+{
+	eventReader.connect(pEventQueue);
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+void
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+disconnect()
+{
+	mInputConnection.disconnect();
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+bool
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+read()
+{
+	// throws std::runtime_error if no input is connected
+	auto pinned = mInputConnection.pin();
+	mInputBuffer.reserve(1);
+
+	// constructed in place, InputT needs no default constructor
+	if (mInputBuffer.fill(pinned, 1) == 0)
+		return false;
+
+	auto accepted = read(std::move(*mInputBuffer.data()));
+	mInputBuffer.clear();
+
+	return accepted;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+bool
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+read(InputT input)
+{
+	if (!mInputDomain(input))
+		return false;
+
+	resolve(input, InPlace());
+
+	return true;
+}
+
+// resolves straight into a lent slot
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+void
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+resolve(InputT const& input, std::true_type)
+{
+	if (mOutputSupplied || pOutputQueue->readers() != 0)
+	{
+		if (auto slot = pOutputProducer->claim())
+		{
+			mResolutionFunction(input, *slot);
+			write(input, *slot, true);
+
+			return;
+		}
+	}
+
+	OutputT output = OutputT();
+	mResolutionFunction(input, output);
+	write(input, output, false);
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+void
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+resolve(InputT const& input, std::false_type)
+{
+	OutputT output(mResolutionFunction(input));
+	write(input, output, false);
+}
+
+// output is either a claimed slot or moved into the output queue
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+void
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+write(InputT const& input, OutputT & output, bool claimed)
+{
+	StateT state(mStateFunction(mCurrentState, input, output));
+
+	// queues without readers are skipped, the state still updates
+	// an unpublished claimed slot is lent again by the next claim
+	if ((mOutputSupplied || pOutputQueue->readers() != 0) &&
+			mOutputDomain(output))
+	{
+		if (claimed)
+			pOutputProducer->commit();
+		else if (auto slot = pOutputProducer->claim())
+		{
+			*slot = std::move(output);
+			pOutputProducer->commit();
+		}
+		else if (!pOutputProducer->tryEnqueue(std::move(output)))
+			++mDrops;
+	}
+
+	if (pEventQueue->readers() != 0)
+		emit<0>(state);
+
+	mCurrentState = state;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+StateT
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+state()
+{
+	return mCurrentState;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+size_t
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+drops() const
+{
+	return mDrops;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+void
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+setOutputQueue(std::shared_ptr<IQueue<OutputT>> outputQueue)
+{
+	if (!outputQueue)
+		throw std::invalid_argument("Queue reference empty");
+
+	pOutputProducer = outputQueue->producer();
+	pOutputQueue = std::move(outputQueue);
+	mOutputSupplied = true;
+}
+
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+template<size_t I>
+typename std::enable_if<I == sizeof...(EventFunctionTs)>::type
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+emit(StateT const&)
+{}
+
+// enqueues the event of function I and the ones after it
+template<
+	typename InputT,
+	typename OutputT,
+	typename StateT,
+	typename EventT,
+	typename InputDomainT,
+	typename OutputDomainT,
+	typename ResolutionT,
+	typename StateFunctionT,
+	typename... EventFunctionTs>
+template<size_t I>
+typename std::enable_if<I < sizeof...(EventFunctionTs)>::type
+StaticDevice<
+	InputT, OutputT, StateT, EventT,
+	InputDomainT, OutputDomainT, ResolutionT, StateFunctionT,
+	EventFunctionTs...>::
+emit(StateT const& state)
+{
+	if (!pEventProducer->tryEnqueue(
+				Event<EventT>(std::get<I>(mEventFunctions)(state))))
+		++mDrops;
+
+	emit<I + 1>(state);
+}
+
+} // namespace device
+} // namespace tamgef
+
+#endif
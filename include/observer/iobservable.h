@@ -7,11 +7,11 @@
 
 #include <memory>
 
-template<typename T> class IObserver;
-
 namespace tamgef {
 namespace observer {
 
+template<typename T> class IObserver;
+
 /// @brief Observable Interface.
 /// @details Entrusted by @p IObserver to implement Observer Pattern.
 /// @sa IObserver<T>
@@ -26,7 +26,7 @@ public:
 	virtual void detachObserver(
 			std::shared_ptr<IObserver<T>> observer) = 0;
 
-	virtual void notifyObservers() = 0;
+	virtual void notifyObservers(T const& message) = 0;
 
 };// class IObservable
 
@@ -6,6 +6,7 @@
 #include <mutex>
 #include <initializer_list>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 
 #include <observer/iobservable.h>
@@ -54,7 +55,7 @@ Observable<T>::Observable(Observable<T> && other) :
 
 template<typename T>
 Observable<T>::Observable(std::initializer_list<std::shared_ptr<IObserver<T>>> observers) :
-	mObservers(observers)
+	mObservers(observers.begin(), observers.end())
 {}
 
 template<typename T>
@@ -0,0 +1,783 @@
+#ifndef BROADCAST_QUEUE_H
+#define BROADCAST_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <queue/event_count.h>
+#include <queue/iqueue.h>
+
+namespace tamgef {
+namespace queue {
+
+/// @brief Single-producer ring buffer where every reader sees every element.
+/// @details Each reader reads through its own cursor, see cursor(). The
+/// producer never overwrites an element a gating cursor hasn't read yet,
+/// blocking instead, so the slowest gating reader sets the pace. Lapping
+/// cursors never hold the producer back and skip what was overwritten
+/// before they got to it; they may copy an element while it's being
+/// overwritten and then discard it, so suit trivially copyable types.
+/// A QueueReader connected to a broadcast queue gets a gating cursor of
+/// its own, unsubscribed again once the last copy of that reader detaches.
+/// The producer finds the slowest gating cursor without locking, scanning
+/// a fixed table of gating positions, so at most sMaxGates gating cursors
+/// can be open at a time.
+template<typename T>
+class BroadcastQueue : public IQueue<T>
+{
+public:
+	class Cursor;
+
+	static const size_t sMaxGates = 64;
+
+	BroadcastQueue(size_t capacity);
+	BroadcastQueue(BroadcastQueue<T> const&) = delete;
+	~BroadcastQueue();
+
+	// elements are only read through cursors, these are about the
+	// slowest gating cursor
+	bool empty() const override;
+	size_t size() const override;
+
+	// blocks while the ring is full
+	void enqueue(T element) override;
+	void enqueueBulk(T const*, size_t) override;
+
+	// throw std::logic_error, read through a cursor instead
+	bool tryDequeue(T &) override;
+	size_t tryDequeueBulk(T*, size_t) override;
+
+	bool wait(std::chrono::microseconds) override;
+
+	std::shared_ptr<IQueue<T>> subscribe() override;
+
+	// number of subscribed cursors
+	size_t readers() const override;
+
+	size_t capacity() const;
+
+	// opens a cursor starting at the next element enqueued
+	// throws std::length_error past sMaxGates gating cursors
+	std::shared_ptr<Cursor> cursor(bool lapping = false);
+
+	// stops the cursor gating the producer, readers connected to it expire
+	void unsubscribe(std::shared_ptr<IQueue<T>> const&);
+
+private:
+	struct Ring;
+
+	std::shared_ptr<Ring> pRing;
+
+	// producer owned
+	size_t mCachedGate;
+
+	size_t claim(size_t tail, size_t count);
+	size_t gate(size_t tail) const;
+};
+
+template<typename T>
+struct BroadcastQueue<T>::Ring
+{
+	static const size_t sCacheLineSize = 64;
+
+	// position of a gate no cursor holds the producer back with
+	static const size_t sClosed = size_t(-1);
+
+	// a gating cursor's position, on a cache line of its own
+	struct Gate
+	{
+		std::atomic<size_t> position;
+		char padding[sCacheLineSize - sizeof(std::atomic<size_t>)];
+	};
+
+	Ring(size_t capacity);
+	~Ring();
+
+	size_t const mask;
+
+	// slots are constructed the first time they're written
+	std::unique_ptr<typename std::aligned_storage<sizeof(T), alignof(T)>::type[]>
+			buffer;
+
+	// per slot seqlock for lapping cursors, odd while being written
+	std::unique_ptr<std::atomic<size_t>[]> sequences;
+
+	// kept with the ring so cursors can unsubscribe themselves
+	mutable std::mutex cursorsMutex;
+	std::vector<std::shared_ptr<Cursor>> cursors;
+	std::vector<size_t> freeGates;
+	std::atomic<size_t> subscribers;
+
+	void remove(IQueue<T> const*);
+
+	// under the lock
+	size_t openGate(size_t position);
+	void closeGate(size_t gate);
+
+	T* element(size_t position);
+
+	template<typename U>
+	void write(size_t position, U && element);
+
+	// scanned by the producer up to the number of gates ever opened
+	Gate gates[sMaxGates];
+	std::atomic<size_t> gateCount;
+
+	char padding[sCacheLineSize];
+	std::atomic<size_t> tail;
+	EventCount notEmpty;
+};
+
+/// @brief A reader's position in a BroadcastQueue.
+/// @details Only one thread may read through a cursor at a time.
+template<typename T>
+class BroadcastQueue<T>::Cursor : public IQueue<T>
+{
+public:
+	Cursor(std::shared_ptr<Ring>, bool lapping);
+	Cursor(Cursor const&) = delete;
+	~Cursor();
+
+	bool empty() const override;
+	size_t size() const override;
+
+	// throw std::logic_error, cursors are read-only
+	void enqueue(T element) override;
+	void enqueueBulk(T const*, size_t) override;
+
+	bool tryDequeue(T &) override;
+	size_t tryDequeueBulk(T*, size_t) override;
+	size_t tryDequeueBulkInto(T*, size_t) override;
+	bool wait(std::chrono::microseconds) override;
+
+	// elements skipped after being overwritten
+	size_t drops() const override;
+
+	bool lapping() const;
+
+	// unsubscribes a cursor opened for QueueReaders once none is left
+	void detachReader() override;
+
+	// points first at the unread elements up to the end of the ring,
+	// returns their number; they stay valid until released
+	// throws std::logic_error for lapping cursors
+	size_t view(T const*& first);
+
+	// marks count viewed elements as read
+	void release(size_t count);
+
+	// sessions of QueueReaders view and release through the cursor
+	std::unique_ptr<typename IQueue<T>::Consumer> consumer() override;
+
+private:
+	friend class BroadcastQueue<T>;
+
+	class ViewingConsumer;
+
+	static const size_t sNoGate = size_t(-1);
+
+	std::shared_ptr<Ring> pRing;
+	bool const mLapping;
+	bool mReaderOwned;
+	std::atomic<size_t> mDrops;
+
+	// gating cursors publish their position to the ring's gate
+	size_t mGate;
+
+	char mPadding[Ring::sCacheLineSize];
+	std::atomic<size_t> mPosition;
+
+	size_t available(size_t position) const;
+	void advance(size_t position, size_t next);
+
+	template<typename Construct>
+	size_t read(T* elements, size_t max, Construct);
+
+	static void copy(T* destination, T const& source, std::false_type);
+	static void copy(T* destination, T const& source, std::true_type);
+	static void discard(T* destination, std::false_type);
+	static void discard(T* destination, std::true_type);
+};
+
+template<typename T>
+class BroadcastQueue<T>::Cursor::ViewingConsumer : public IQueue<T>::Consumer
+{
+public:
+	ViewingConsumer(Cursor & cursor) :
+		mCursor(cursor)
+	{}
+
+	bool tryDequeue(T & element) override
+	{
+		return mCursor.tryDequeue(element);
+	}
+
+	size_t tryDequeueBulk(T* elements, size_t max) override
+	{
+		return mCursor.tryDequeueBulk(elements, max);
+	}
+
+	size_t tryDequeueBulkInto(T* storage, size_t max) override
+	{
+		return mCursor.tryDequeueBulkInto(storage, max);
+	}
+
+	size_t view(T const*& first) override
+	{
+		return mCursor.view(first);
+	}
+
+	void release(size_t count) override
+	{
+		mCursor.release(count);
+	}
+
+private:
+	Cursor & mCursor;
+};
+
+template<typename T>
+const size_t BroadcastQueue<T>::sMaxGates;
+
+template<typename T>
+BroadcastQueue<T>::Ring::Ring(size_t capacity) :
+	mask(capacity - 1),
+	buffer(new typename std::aligned_storage<sizeof(T), alignof(T)>::type[capacity]),
+	sequences(new std::atomic<size_t>[capacity]),
+	subscribers(0),
+	gateCount(0),
+	tail(0)
+{
+	for (size_t i = 0; i < capacity; ++i)
+		sequences[i].store(0, std::memory_order_relaxed);
+
+	for (auto & gate : gates)
+		gate.position.store(sClosed, std::memory_order_relaxed);
+
+	// cursors return their gates while being destroyed
+	freeGates.reserve(sMaxGates);
+}
+
+template<typename T>
+BroadcastQueue<T>::Ring::~Ring()
+{
+	auto written = std::min(tail.load(std::memory_order_relaxed), mask + 1);
+
+	for (size_t i = 0; i < written; ++i)
+		element(i)->~T();
+}
+
+template<typename T>
+void BroadcastQueue<T>::Ring::remove(IQueue<T> const* cursor)
+{
+	std::shared_ptr<Cursor> removed;
+	std::lock_guard<std::mutex> lock(cursorsMutex);
+
+	auto found = std::find_if(cursors.begin(), cursors.end(),
+			[cursor](std::shared_ptr<Cursor> const& subscribed)
+			{
+				return subscribed.get() == cursor;
+			});
+
+	if (found == cursors.end())
+		return;
+
+	// its gate stays taken until the cursor is gone, it may still be read
+	if (!(*found)->mLapping)
+		gates[(*found)->mGate].position.store(sClosed, std::memory_order_release);
+
+	// released after the lock
+	removed = std::move(*found);
+	cursors.erase(found);
+	subscribers.store(cursors.size(), std::memory_order_relaxed);
+}
+
+template<typename T>
+size_t BroadcastQueue<T>::Ring::openGate(size_t position)
+{
+	size_t gate;
+
+	if (!freeGates.empty())
+	{
+		gate = freeGates.back();
+		freeGates.pop_back();
+	}
+	else if ((gate = gateCount.load(std::memory_order_relaxed)) == sMaxGates)
+		throw std::length_error("Too many gating cursors");
+
+	gates[gate].position.store(position, std::memory_order_relaxed);
+
+	if (gate == gateCount.load(std::memory_order_relaxed))
+		gateCount.store(gate + 1, std::memory_order_relaxed);
+
+	return gate;
+}
+
+template<typename T>
+void BroadcastQueue<T>::Ring::closeGate(size_t gate)
+{
+	gates[gate].position.store(sClosed, std::memory_order_release);
+	freeGates.push_back(gate);
+}
+
+template<typename T>
+T* BroadcastQueue<T>::Ring::element(size_t position)
+{
+	return reinterpret_cast<T*>(&buffer[position & mask]);
+}
+
+// slots past the first lap hold an element already
+template<typename T>
+template<typename U>
+void BroadcastQueue<T>::Ring::write(size_t position, U && value)
+{
+	if (position > mask)
+		*element(position) = std::forward<U>(value);
+	else
+		::new (element(position)) T(std::forward<U>(value));
+}
+
+template<typename T>
+BroadcastQueue<T>::BroadcastQueue(size_t capacity) :
+	mCachedGate(0)
+{
+	if (capacity == 0)
+		throw std::invalid_argument("Empty ring capacity");
+
+	size_t powerOfTwo = 1;
+
+	while (powerOfTwo < capacity)
+		powerOfTwo <<= 1;
+
+	pRing = std::make_shared<Ring>(powerOfTwo);
+}
+
+// cursors share the ring, drop them so their readers expire
+template<typename T>
+BroadcastQueue<T>::~BroadcastQueue()
+{
+	std::vector<std::shared_ptr<Cursor>> cursors;
+	std::lock_guard<std::mutex> lock(pRing->cursorsMutex);
+
+	cursors.swap(pRing->cursors);
+	pRing->subscribers.store(0, std::memory_order_relaxed);
+}
+
+template<typename T>
+bool BroadcastQueue<T>::empty() const
+{
+	return size() == 0;
+}
+
+template<typename T>
+size_t BroadcastQueue<T>::size() const
+{
+	auto tail = pRing->tail.load(std::memory_order_acquire);
+
+	return tail - gate(tail);
+}
+
+template<typename T>
+void BroadcastQueue<T>::enqueue(T element)
+{
+	auto tail = pRing->tail.load(std::memory_order_relaxed);
+	claim(tail, 1);
+
+	auto & sequence = pRing->sequences[tail & pRing->mask];
+	sequence.store(2 * tail + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	pRing->write(tail, std::move(element));
+
+	sequence.store(2 * tail + 2, std::memory_order_release);
+	pRing->tail.store(tail + 1, std::memory_order_release);
+	pRing->notEmpty.notifyAll();
+}
+
+template<typename T>
+void BroadcastQueue<T>::enqueueBulk(T const* elements, size_t count)
+{
+	while (count != 0)
+	{
+		auto tail = pRing->tail.load(std::memory_order_relaxed);
+		auto claimed = claim(tail, count);
+
+		for (size_t i = 0; i < claimed; ++i)
+		{
+			auto & sequence = pRing->sequences[(tail + i) & pRing->mask];
+			sequence.store(2 * (tail + i) + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			pRing->write(tail + i, elements[i]);
+
+			sequence.store(2 * (tail + i) + 2, std::memory_order_release);
+		}
+
+		pRing->tail.store(tail + claimed, std::memory_order_release);
+		pRing->notEmpty.notifyAll();
+
+		elements += claimed;
+		count -= claimed;
+	}
+}
+
+template<typename T>
+bool BroadcastQueue<T>::tryDequeue(T &)
+{
+	throw std::logic_error("Broadcast queues are read through cursors");
+}
+
+template<typename T>
+size_t BroadcastQueue<T>::tryDequeueBulk(T*, size_t)
+{
+	throw std::logic_error("Broadcast queues are read through cursors");
+}
+
+template<typename T>
+bool BroadcastQueue<T>::wait(std::chrono::microseconds timeout)
+{
+	return pRing->notEmpty.waitFor(
+			[this]() -> bool
+			{
+				return !empty();
+			},
+			timeout);
+}
+
+template<typename T>
+std::shared_ptr<IQueue<T>> BroadcastQueue<T>::subscribe()
+{
+	auto subscription = cursor();
+	subscription->mReaderOwned = true;
+
+	return subscription;
+}
+
+template<typename T>
+size_t BroadcastQueue<T>::readers() const
+{
+	return pRing->subscribers.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+size_t BroadcastQueue<T>::capacity() const
+{
+	return pRing->mask + 1;
+}
+
+template<typename T>
+std::shared_ptr<typename BroadcastQueue<T>::Cursor>
+BroadcastQueue<T>::cursor(bool lapping)
+{
+	auto cursor = std::make_shared<Cursor>(pRing, lapping);
+	std::lock_guard<std::mutex> lock(pRing->cursorsMutex);
+	auto tail = pRing->tail.load(std::memory_order_acquire);
+
+	pRing->cursors.push_back(cursor);
+
+	if (!lapping)
+	{
+		try
+		{
+			cursor->mGate = pRing->openGate(tail);
+		}
+		catch (...)
+		{
+			pRing->cursors.pop_back();
+			throw;
+		}
+
+		// pairs with the fence in gate(): either the producer sees the new
+		// gate or it published the tail read here before scanning, and
+		// can't overwrite anything from there on without scanning again
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		tail = pRing->tail.load(std::memory_order_acquire);
+		pRing->gates[cursor->mGate].position.store(tail,
+				std::memory_order_relaxed);
+	}
+
+	cursor->mPosition.store(tail, std::memory_order_relaxed);
+	pRing->subscribers.store(pRing->cursors.size(), std::memory_order_relaxed);
+
+	return cursor;
+}
+
+template<typename T>
+void BroadcastQueue<T>::unsubscribe(std::shared_ptr<IQueue<T>> const& cursor)
+{
+	pRing->remove(cursor.get());
+}
+
+// waits for room in the ring, returns how many of count elements fit
+template<typename T>
+size_t BroadcastQueue<T>::claim(size_t tail, size_t count)
+{
+	auto capacity = this->capacity();
+
+	while (tail - mCachedGate >= capacity)
+	{
+		mCachedGate = gate(tail);
+
+		if (tail - mCachedGate >= capacity)
+			std::this_thread::yield();
+	}
+
+	return std::min(count, capacity - (tail - mCachedGate));
+}
+
+// position of the slowest gating cursor, tail if there is none
+template<typename T>
+size_t BroadcastQueue<T>::gate(size_t tail) const
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	auto count = pRing->gateCount.load(std::memory_order_relaxed);
+
+	// closed gates are past any tail
+	for (size_t i = 0; i < count; ++i)
+		tail = std::min(tail,
+				pRing->gates[i].position.load(std::memory_order_acquire));
+
+	return tail;
+}
+
+template<typename T>
+BroadcastQueue<T>::Cursor::Cursor(std::shared_ptr<Ring> ring, bool lapping) :
+	pRing(std::move(ring)),
+	mLapping(lapping),
+	mReaderOwned(false),
+	mDrops(0),
+	mGate(sNoGate),
+	mPosition(0)
+{}
+
+template<typename T>
+BroadcastQueue<T>::Cursor::~Cursor()
+{
+	if (mGate == sNoGate)
+		return;
+
+	std::lock_guard<std::mutex> lock(pRing->cursorsMutex);
+	pRing->closeGate(mGate);
+}
+
+template<typename T>
+bool BroadcastQueue<T>::Cursor::empty() const
+{
+	return size() == 0;
+}
+
+template<typename T>
+size_t BroadcastQueue<T>::Cursor::size() const
+{
+	return std::min(
+			available(mPosition.load(std::memory_order_relaxed)),
+			pRing->mask + 1);
+}
+
+template<typename T>
+void BroadcastQueue<T>::Cursor::enqueue(T)
+{
+	throw std::logic_error("Broadcast cursors are read-only");
+}
+
+template<typename T>
+void BroadcastQueue<T>::Cursor::enqueueBulk(T const*, size_t)
+{
+	throw std::logic_error("Broadcast cursors are read-only");
+}
+
+template<typename T>
+bool BroadcastQueue<T>::Cursor::tryDequeue(T & element)
+{
+	return tryDequeueBulk(&element, 1) == 1;
+}
+
+template<typename T>
+size_t BroadcastQueue<T>::Cursor::tryDequeueBulk(T* elements, size_t max)
+{
+	return read(elements, max, std::false_type());
+}
+
+// copy constructs into storage, so suits types without a default constructor
+template<typename T>
+size_t BroadcastQueue<T>::Cursor::tryDequeueBulkInto(T* storage, size_t max)
+{
+	return read(storage, max, std::true_type());
+}
+
+template<typename T>
+bool BroadcastQueue<T>::Cursor::wait(std::chrono::microseconds timeout)
+{
+	return pRing->notEmpty.waitFor(
+			[this]() -> bool
+			{
+				return !empty();
+			},
+			timeout);
+}
+
+template<typename T>
+size_t BroadcastQueue<T>::Cursor::drops() const
+{
+	return mDrops.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+bool BroadcastQueue<T>::Cursor::lapping() const
+{
+	return mLapping;
+}
+
+template<typename T>
+void BroadcastQueue<T>::Cursor::detachReader()
+{
+	IQueue<T>::detachReader();
+
+	if (mReaderOwned && IQueue<T>::readers() == 0)
+		pRing->remove(this);
+}
+
+template<typename T>
+size_t BroadcastQueue<T>::Cursor::view(T const*& first)
+{
+	if (mLapping)
+		throw std::logic_error("Lapping cursors can't view elements in place");
+
+	auto position = mPosition.load(std::memory_order_relaxed);
+	auto index = position & pRing->mask;
+
+	first = pRing->element(index);
+
+	return std::min(available(position), pRing->mask + 1 - index);
+}
+
+template<typename T>
+void BroadcastQueue<T>::Cursor::release(size_t count)
+{
+	auto position = mPosition.load(std::memory_order_relaxed);
+
+	advance(position, position + std::min(count, available(position)));
+}
+
+template<typename T>
+std::unique_ptr<typename IQueue<T>::Consumer>
+BroadcastQueue<T>::Cursor::consumer()
+{
+	return std::unique_ptr<typename IQueue<T>::Consumer>(
+			new ViewingConsumer(*this));
+}
+
+template<typename T>
+size_t BroadcastQueue<T>::Cursor::available(size_t position) const
+{
+	return pRing->tail.load(std::memory_order_acquire) - position;
+}
+
+// a gate closed by unsubscribing stays closed
+template<typename T>
+void BroadcastQueue<T>::Cursor::advance(size_t position, size_t next)
+{
+	mPosition.store(next, std::memory_order_release);
+
+	if (mGate != sNoGate)
+		pRing->gates[mGate].position.compare_exchange_strong(position, next,
+				std::memory_order_release, std::memory_order_relaxed);
+}
+
+// assigns into elements or constructs into storage, as Construct says
+template<typename T>
+template<typename Construct>
+size_t BroadcastQueue<T>::Cursor::read(T* elements, size_t max, Construct)
+{
+	auto position = mPosition.load(std::memory_order_relaxed);
+	auto tail = pRing->tail.load(std::memory_order_acquire);
+	auto count = std::min(max, tail - position);
+
+	if (!mLapping)
+	{
+		for (size_t i = 0; i < count; ++i)
+			copy(elements + i, *pRing->element(position + i), Construct());
+
+		advance(position, position + count);
+
+		return count;
+	}
+
+	auto capacity = pRing->mask + 1;
+
+	// lapped, skip to the oldest element still in the ring
+	if (tail - position > capacity)
+	{
+		mDrops.fetch_add(tail - position - capacity, std::memory_order_relaxed);
+		position = tail - capacity;
+		count = std::min(max, capacity);
+	}
+
+	size_t copied = 0;
+
+	for (size_t i = 0; i < count; ++i, ++position)
+	{
+		auto & sequence = pRing->sequences[position & pRing->mask];
+		auto expected = 2 * position + 2;
+
+		if (sequence.load(std::memory_order_acquire) != expected)
+		{
+			mDrops.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+
+		copy(elements + copied, *pRing->element(position), Construct());
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		// overwritten while being copied
+		if (sequence.load(std::memory_order_relaxed) != expected)
+		{
+			discard(elements + copied, Construct());
+			mDrops.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+
+		++copied;
+	}
+
+	mPosition.store(position, std::memory_order_release);
+
+	return copied;
+}
+
+template<typename T>
+void BroadcastQueue<T>::Cursor::copy(T* destination, T const& source,
+		std::false_type)
+{
+	*destination = source;
+}
+
+template<typename T>
+void BroadcastQueue<T>::Cursor::copy(T* destination, T const& source,
+		std::true_type)
+{
+	::new (destination) T(source);
+}
+
+template<typename T>
+void BroadcastQueue<T>::Cursor::discard(T*, std::false_type)
+{}
+
+template<typename T>
+void BroadcastQueue<T>::Cursor::discard(T* destination, std::true_type)
+{
+	destination->~T();
+}
+
+} // namespace queue
+} // namespace tamgef
+
+#endif
@@ -0,0 +1,232 @@
+#ifndef CONFLATING_QUEUE_H
+#define CONFLATING_QUEUE_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <queue/event_count.h>
+#include <queue/iqueue.h>
+
+namespace tamgef {
+namespace queue {
+
+/// @brief Queue holding only the newest element, or the newest element
+/// per key.
+/// @details Suits streams where readers only care about the latest
+/// sample, like cursor positions or one touch contact each. An element
+/// replacing one that wasn't dequeued yet keeps the replaced one's place
+/// in line and counts as a drop. Memory is fixed at one element per key.
+template<typename T>
+class ConflatingQueue : public IQueue<T>
+{
+public:
+	/// @brief Maps an element to its key, in [0, keys).
+	typedef std::function<size_t(T const&)> KeyFunction;
+
+	// keeps the newest element
+	ConflatingQueue();
+
+	// keeps the newest element per key
+	// throws std::invalid_argument if there are no keys or no function
+	ConflatingQueue(size_t keys, KeyFunction);
+
+	ConflatingQueue(ConflatingQueue<T> const&) = delete;
+
+	bool empty() const override;
+
+	// throws std::out_of_range if the element's key is out of range
+	void enqueue(T element) override;
+	size_t size() const override;
+
+	void enqueueBulk(T const*, size_t) override;
+	bool tryDequeue(T &) override;
+	size_t tryDequeueBulk(T*, size_t) override;
+	bool wait(std::chrono::microseconds) override;
+
+	// number of elements replaced before being dequeued
+	size_t drops() const override;
+
+	size_t keys() const;
+
+private:
+	static const size_t sNone = ~size_t(0);
+
+	KeyFunction const mKey;
+
+	mutable std::mutex mMutex;
+	std::vector<T> mValues;
+
+	// keys holding an element, oldest first, linked through mNext
+	std::vector<size_t> mNext;
+	std::vector<bool> mPending;
+	size_t mHead;
+	size_t mTail;
+
+	std::atomic<size_t> mSize;
+	std::atomic<size_t> mDrops;
+	EventCount mNotEmpty;
+
+	size_t checkKey(size_t key) const;
+	void insert(T const& element);
+};
+
+template<typename T>
+const size_t ConflatingQueue<T>::sNone;
+
+template<typename T>
+ConflatingQueue<T>::ConflatingQueue() :
+	ConflatingQueue(1, [](T const&) -> size_t { return 0; })
+{}
+
+template<typename T>
+ConflatingQueue<T>::ConflatingQueue(size_t keys, KeyFunction key) :
+	mKey(std::move(key)),
+	mValues(keys),
+	mNext(keys, sNone),
+	mPending(keys, false),
+	mHead(sNone),
+	mTail(sNone),
+	mSize(0),
+	mDrops(0)
+{
+	if (keys == 0)
+		throw std::invalid_argument("Empty key range");
+
+	if (!mKey)
+		throw std::invalid_argument("Empty key function");
+}
+
+template<typename T>
+bool ConflatingQueue<T>::empty() const
+{
+	return size() == 0;
+}
+
+template<typename T>
+void ConflatingQueue<T>::enqueue(T element)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		insert(element);
+	}
+
+	mNotEmpty.notifyAll();
+}
+
+template<typename T>
+size_t ConflatingQueue<T>::size() const
+{
+	return mSize.load(std::memory_order_acquire);
+}
+
+template<typename T>
+void ConflatingQueue<T>::enqueueBulk(T const* elements, size_t count)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		for (size_t i = 0; i < count; ++i)
+			insert(elements[i]);
+	}
+
+	mNotEmpty.notifyAll();
+}
+
+template<typename T>
+bool ConflatingQueue<T>::tryDequeue(T & element)
+{
+	return tryDequeueBulk(&element, 1) == 1;
+}
+
+template<typename T>
+size_t ConflatingQueue<T>::tryDequeueBulk(T* elements, size_t max)
+{
+	if (empty())
+		return 0;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	size_t count = 0;
+
+	while (count < max && mHead != sNone)
+	{
+		auto key = mHead;
+
+		elements[count++] = std::move(mValues[key]);
+		mPending[key] = false;
+
+		mHead = mNext[key];
+		mNext[key] = sNone;
+	}
+
+	if (mHead == sNone)
+		mTail = sNone;
+
+	mSize.fetch_sub(count, std::memory_order_release);
+
+	return count;
+}
+
+template<typename T>
+bool ConflatingQueue<T>::wait(std::chrono::microseconds timeout)
+{
+	return mNotEmpty.waitFor(
+			[this]() -> bool
+			{
+				return !empty();
+			},
+			timeout);
+}
+
+template<typename T>
+size_t ConflatingQueue<T>::drops() const
+{
+	return mDrops.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+size_t ConflatingQueue<T>::keys() const
+{
+	return mValues.size();
+}
+
+template<typename T>
+size_t ConflatingQueue<T>::checkKey(size_t key) const
+{
+	if (key >= mValues.size())
+		throw std::out_of_range("Element key out of range");
+
+	return key;
+}
+
+// replaces the element of the same key, or lines up a new one
+template<typename T>
+void ConflatingQueue<T>::insert(T const& element)
+{
+	auto key = checkKey(mKey(element));
+
+	mValues[key] = element;
+
+	if (mPending[key])
+	{
+		mDrops.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	mPending[key] = true;
+
+	if (mTail == sNone)
+		mHead = key;
+	else
+		mNext[mTail] = key;
+
+	mTail = key;
+	mSize.fetch_add(1, std::memory_order_release);
+}
+
+} // namespace queue
+} // namespace tamgef
+
+#endif
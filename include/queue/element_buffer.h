@@ -0,0 +1,122 @@
+#ifndef ELEMENT_BUFFER_H
+#define ELEMENT_BUFFER_H
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+
+namespace tamgef {
+namespace queue {
+
+/// @brief Reusable storage elements are dequeued into.
+/// @details Elements are only constructed by fill(), so types without a
+/// default constructor can be dequeued. They live until clear(), the next
+/// reserve() or the buffer's destruction.
+template<typename T>
+class ElementBuffer
+{
+public:
+	ElementBuffer(size_t capacity = 0);
+	ElementBuffer(ElementBuffer<T> const&) = delete;
+	ElementBuffer(ElementBuffer<T> &&);
+	~ElementBuffer();
+
+	T* data();
+	size_t size() const;
+	size_t capacity() const;
+
+	// destroys the elements held, growing the storage if needed
+	void reserve(size_t capacity);
+
+	// appends up to max elements dequeued from a queue, reader session or
+	// consumer session through tryDequeueBulkInto(), returns their number
+	template<typename Source>
+	size_t fill(Source &, size_t max);
+
+	void clear();
+
+private:
+	typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+	std::unique_ptr<Storage[]> pStorage;
+	size_t mCapacity;
+	size_t mSize;
+};
+
+template<typename T>
+ElementBuffer<T>::ElementBuffer(size_t capacity) :
+	pStorage(capacity != 0 ? new Storage[capacity] : nullptr),
+	mCapacity(capacity),
+	mSize(0)
+{}
+
+template<typename T>
+ElementBuffer<T>::ElementBuffer(ElementBuffer<T> && other) :
+	pStorage(std::move(other.pStorage)),
+	mCapacity(other.mCapacity),
+	mSize(other.mSize)
+{
+	other.mCapacity = 0;
+	other.mSize = 0;
+}
+
+template<typename T>
+ElementBuffer<T>::~ElementBuffer()
+{
+	clear();
+}
+
+template<typename T>
+T* ElementBuffer<T>::data()
+{
+	return reinterpret_cast<T*>(pStorage.get());
+}
+
+template<typename T>
+size_t ElementBuffer<T>::size() const
+{
+	return mSize;
+}
+
+template<typename T>
+size_t ElementBuffer<T>::capacity() const
+{
+	return mCapacity;
+}
+
+template<typename T>
+void ElementBuffer<T>::reserve(size_t capacity)
+{
+	clear();
+
+	if (capacity <= mCapacity)
+		return;
+
+	pStorage.reset(new Storage[capacity]);
+	mCapacity = capacity;
+}
+
+template<typename T>
+template<typename Source>
+size_t ElementBuffer<T>::fill(Source & source, size_t max)
+{
+	auto count = source.tryDequeueBulkInto(
+			data() + mSize, std::min(max, mCapacity - mSize));
+	mSize += count;
+
+	return count;
+}
+
+template<typename T>
+void ElementBuffer<T>::clear()
+{
+	for (size_t i = 0; i < mSize; ++i)
+		data()[i].~T();
+
+	mSize = 0;
+}
+
+} // namespace queue
+} // namespace tamgef
+
+#endif
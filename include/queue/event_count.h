@@ -0,0 +1,74 @@
+#ifndef EVENT_COUNT_H
+#define EVENT_COUNT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace tamgef {
+namespace queue {
+
+/// @brief Lets threads sleep until a lock-free condition becomes true.
+/// @details Notifiers only pay for a fence and a load while nobody is
+/// waiting, so it can sit on the enqueue path of lock-free queues.
+class EventCount
+{
+public:
+	EventCount();
+	EventCount(EventCount const&) = delete;
+
+	// wakes all waiters, call after making the condition true
+	void notifyAll();
+
+	// returns the value of ready, waiting up to timeout for it to be true
+	template<typename Predicate, typename Rep, typename Period>
+	bool waitFor(Predicate ready, std::chrono::duration<Rep, Period> timeout);
+
+private:
+	std::atomic<size_t> mWaiters;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+};
+
+inline EventCount::EventCount() :
+	mWaiters(0)
+{}
+
+inline void EventCount::notifyAll()
+{
+	// pairs with the increment in waitFor, either the waiter sees the
+	// new condition or the notifier sees the waiter
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (mWaiters.load(std::memory_order_relaxed) == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+	}
+
+	mCondition.notify_all();
+}
+
+template<typename Predicate, typename Rep, typename Period>
+bool EventCount::waitFor(Predicate ready,
+		std::chrono::duration<Rep, Period> timeout)
+{
+	if (ready())
+		return true;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mWaiters.fetch_add(1, std::memory_order_seq_cst);
+
+	auto result = mCondition.wait_for(lock, timeout, ready);
+
+	mWaiters.fetch_sub(1, std::memory_order_relaxed);
+
+	return result;
+}
+
+} // namespace queue
+} // namespace tamgef
+
+#endif
@@ -2,7 +2,12 @@
 #ifndef IQUEUE_H
 #define IQUEUE_H
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
 
 namespace tamgef {
 namespace queue {
@@ -12,15 +17,325 @@ template <typename T>
 class IQueue
 {
 public:
+	/// @brief Enqueue session owned by a single producer thread.
+	class Producer
+	{
+	public:
+		virtual ~Producer() = default;
+
+		virtual void enqueue(T element) = 0;
+		virtual void enqueueBulk(T const* elements, size_t count) = 0;
+
+		/// @brief Enqueue without throwing when a ring is full.
+		/// @sa IQueue::tryEnqueue()
+		virtual bool tryEnqueue(T element)
+		{
+			enqueue(std::move(element));
+			return true;
+		}
+
+		virtual size_t tryEnqueueBulk(T const* elements, size_t count)
+		{
+			enqueueBulk(elements, count);
+			return count;
+		}
+
+		/// @brief Lend the next free slot to be filled in place.
+		/// @returns @p nullptr if the queue is full or doesn't lend slots.
+		virtual T* claim() { return nullptr; }
+
+		/// @brief Publish the slot returned by the last claim().
+		virtual void commit() { throw std::logic_error("No slot claimed"); }
+	};
+
+	/// @brief Dequeue session owned by a single consumer thread.
+	class Consumer
+	{
+	public:
+		virtual ~Consumer() = default;
+
+		virtual bool tryDequeue(T & element) = 0;
+		virtual size_t tryDequeueBulk(T* elements, size_t max) = 0;
+
+		/// @sa IQueue::tryDequeueBulkInto()
+		virtual size_t tryDequeueBulkInto(T* storage, size_t max)
+		{
+			return dequeueInto(storage, max,
+					[this](T* elements, size_t count) -> size_t
+					{
+						return tryDequeueBulk(elements, count);
+					},
+					std::is_default_constructible<T>());
+		}
+
+		/// @brief Point @p first at unread elements to be read in place.
+		/// @returns Their number; they stay valid until released.
+		virtual size_t view(T const*&)
+		{
+			throw std::logic_error("Queue doesn't lend elements");
+		}
+
+		/// @brief Mark @p count viewed elements as read.
+		virtual void release(size_t)
+		{
+			throw std::logic_error("Queue doesn't lend elements");
+		}
+	};
+
+	IQueue();
 	virtual ~IQueue() = default;
 
-	virtual T dequeue() = 0;
+	/// @brief Dequeue one element, or a default constructed one if the
+	/// queue is empty.
+	/// @details Not virtual, so it's only instantiated when called and
+	/// queues of types without a default constructor still compile.
+	T dequeue();
+
 	virtual bool empty() const = 0;
 	virtual void enqueue(T element) = 0;
 	virtual size_t size() const = 0;
 
+	/// @brief Move the oldest element into @p element.
+	/// @returns @p false, leaving @p element untouched, if the queue is
+	/// empty.
+	virtual bool tryDequeue(T & element) = 0;
+
+	/// @brief Enqueue @p count elements starting at @p elements.
+	virtual void enqueueBulk(T const* elements, size_t count) = 0;
+
+	/// @brief Enqueue @p element unless the queue is full.
+	/// @returns @p false if it wasn't enqueued. Queues applying an
+	/// overflow policy of their own always return @p true.
+	virtual bool tryEnqueue(T element);
+
+	/// @brief Enqueue as many of @p count elements as fit, in order.
+	/// @returns Number of elements enqueued.
+	virtual size_t tryEnqueueBulk(T const* elements, size_t count);
+
+	/// @brief Dequeue up to @p max elements into @p elements.
+	/// @returns Number of elements dequeued.
+	virtual size_t tryDequeueBulk(T* elements, size_t max) = 0;
+
+	/// @brief Dequeue up to @p max elements into uninitialized @p storage.
+	/// @details Moves elements into place, so the caller destroys them.
+	/// The default default constructs elements to dequeue into and throws
+	/// std::logic_error for types without a default constructor, queues
+	/// override it to support those.
+	/// @returns Number of elements constructed.
+	virtual size_t tryDequeueBulkInto(T* storage, size_t max);
+
+	/// @brief Block until the queue is not empty or @p timeout passes.
+	/// @returns @p true if the queue is not empty.
+	virtual bool wait(std::chrono::microseconds timeout) = 0;
+
+	/// @brief Number of elements discarded by a bounded queue.
+	virtual size_t drops() const { return 0; }
+
+	/// @brief Number of enqueues that found a bounded queue full.
+	virtual size_t overflows() const { return 0; }
+
+	/// @brief Queue a newly connected reader reads from.
+	/// @details Readers of most queues compete for elements and read
+	/// from the queue itself, which is returned as null. Queues that
+	/// give each reader its own view, like BroadcastQueue, return it.
+	virtual std::shared_ptr<IQueue<T>> subscribe() { return nullptr; }
+
+	/// @brief Number of QueueReaders connected to this queue.
+	/// @details Lets producers skip work nobody would read.
+	virtual size_t readers() const;
+
+	/// @brief Count a QueueReader connecting or disconnecting.
+	void attachReader();
+	virtual void detachReader();
+
+	/// @brief Open a producer session on this queue.
+	/// @details Sessions must not outlive the queue. The default session
+	/// forwards to the queue, implementations override it when they can
+	/// enqueue faster on behalf of a known producer.
+	virtual std::unique_ptr<Producer> producer();
+
+	/// @brief Open a consumer session on this queue.
+	/// @sa producer()
+	virtual std::unique_ptr<Consumer> consumer();
+
+private:
+	class ForwardingProducer;
+	class ForwardingConsumer;
+
+	std::atomic<size_t> mReaders;
+
+	template<typename Dequeue>
+	static size_t dequeueInto(T* storage, size_t max, Dequeue, std::true_type);
+	template<typename Dequeue>
+	static size_t dequeueInto(T* storage, size_t max, Dequeue, std::false_type);
+
+};
+
+template<typename T>
+class IQueue<T>::ForwardingProducer : public IQueue<T>::Producer
+{
+public:
+	ForwardingProducer(IQueue<T> & queue) :
+		mQueue(queue)
+	{}
+
+	void enqueue(T element) override
+	{
+		mQueue.enqueue(std::move(element));
+	}
+
+	void enqueueBulk(T const* elements, size_t count) override
+	{
+		mQueue.enqueueBulk(elements, count);
+	}
+
+	bool tryEnqueue(T element) override
+	{
+		return mQueue.tryEnqueue(std::move(element));
+	}
+
+	size_t tryEnqueueBulk(T const* elements, size_t count) override
+	{
+		return mQueue.tryEnqueueBulk(elements, count);
+	}
+
+private:
+	IQueue<T> & mQueue;
 };
 
+template<typename T>
+class IQueue<T>::ForwardingConsumer : public IQueue<T>::Consumer
+{
+public:
+	ForwardingConsumer(IQueue<T> & queue) :
+		mQueue(queue)
+	{}
+
+	bool tryDequeue(T & element) override
+	{
+		return mQueue.tryDequeue(element);
+	}
+
+	size_t tryDequeueBulk(T* elements, size_t max) override
+	{
+		return mQueue.tryDequeueBulk(elements, max);
+	}
+
+	size_t tryDequeueBulkInto(T* storage, size_t max) override
+	{
+		return mQueue.tryDequeueBulkInto(storage, max);
+	}
+
+private:
+	IQueue<T> & mQueue;
+};
+
+template<typename T>
+IQueue<T>::IQueue() :
+	mReaders(0)
+{}
+
+template<typename T>
+T IQueue<T>::dequeue()
+{
+	T element = T();
+	tryDequeue(element);
+
+	return element;
+}
+
+template<typename T>
+bool IQueue<T>::tryEnqueue(T element)
+{
+	enqueue(std::move(element));
+	return true;
+}
+
+template<typename T>
+size_t IQueue<T>::tryEnqueueBulk(T const* elements, size_t count)
+{
+	enqueueBulk(elements, count);
+	return count;
+}
+
+template<typename T>
+size_t IQueue<T>::tryDequeueBulkInto(T* storage, size_t max)
+{
+	return dequeueInto(storage, max,
+			[this](T* elements, size_t count) -> size_t
+			{
+				return tryDequeueBulk(elements, count);
+			},
+			std::is_default_constructible<T>());
+}
+
+template<typename T>
+size_t IQueue<T>::readers() const
+{
+	return mReaders.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+void IQueue<T>::attachReader()
+{
+	mReaders.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename T>
+void IQueue<T>::detachReader()
+{
+	mReaders.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template<typename T>
+std::unique_ptr<typename IQueue<T>::Producer> IQueue<T>::producer()
+{
+	return std::unique_ptr<Producer>(new ForwardingProducer(*this));
+}
+
+template<typename T>
+std::unique_ptr<typename IQueue<T>::Consumer> IQueue<T>::consumer()
+{
+	return std::unique_ptr<Consumer>(new ForwardingConsumer(*this));
+}
+
+template<typename T>
+template<typename Dequeue>
+size_t IQueue<T>::
+dequeueInto(T* storage, size_t max, Dequeue dequeue, std::true_type)
+{
+	for (size_t i = 0; i < max; ++i)
+		::new (storage + i) T();
+
+	size_t count = 0;
+
+	try
+	{
+		count = dequeue(storage, max);
+	}
+	catch (...)
+	{
+		for (size_t i = 0; i < max; ++i)
+			storage[i].~T();
+
+		throw;
+	}
+
+	for (size_t i = count; i < max; ++i)
+		storage[i].~T();
+
+	return count;
+}
+
+template<typename T>
+template<typename Dequeue>
+size_t IQueue<T>::
+dequeueInto(T*, size_t, Dequeue, std::false_type)
+{
+	throw std::logic_error(
+			"Queue can't dequeue elements without a default constructor");
+}
+
 } // namespace queue 
 } // namespace tamgef
 #endif
@@ -0,0 +1,254 @@
+#ifndef POLLER_EXECUTOR_H
+#define POLLER_EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <queue/wait_strategy.h>
+
+namespace tamgef {
+namespace queue {
+
+/// @brief Fixed pool of worker threads multiplexing many polling tasks.
+/// @details Workers sweep the registered tasks round-robin. A task is run
+/// by one worker at a time and is given a budget of its weight times the
+/// quantum per visit, so heavier queues get drained proportionally more.
+/// When a whole sweep finds nothing to do, workers idle using the wait
+/// strategy, where parking sleeps for the given timeout.
+class PollerExecutor
+{
+public:
+	/// @brief Drains up to budget messages, returns the number drained.
+	typedef std::function<size_t(size_t budget)> Task;
+
+	PollerExecutor(
+			size_t workers = std::max(1u, std::thread::hardware_concurrency()),
+			size_t quantum = 16,
+			std::shared_ptr<WaitStrategy const> waitStrategy =
+				std::make_shared<AdaptiveWait>(
+					100, 10, std::chrono::microseconds(100)));
+	PollerExecutor(PollerExecutor const&) = delete;
+	virtual ~PollerExecutor();
+
+	// registers task, returns id used to remove it
+	// throws std::invalid_argument if task is empty or weight is 0
+	size_t add(Task, size_t weight = 1);
+
+	// deregisters task, blocks until no worker is running it
+	// called from a task, returns right away instead, the task is only
+	// left to finish a run already under way
+	void remove(size_t id);
+
+	size_t size() const;
+	size_t workers() const;
+
+private:
+	struct Slot
+	{
+		Slot(size_t id, Task task, size_t weight) :
+			id(id),
+			task(std::move(task)),
+			weight(weight),
+			running(false),
+			removed(false)
+		{}
+
+		size_t const id;
+		Task const task;
+		size_t const weight;
+		std::atomic<bool> running;
+		std::atomic<bool> removed;
+	};
+
+	typedef std::vector<std::shared_ptr<Slot>> SlotList;
+
+	size_t const mQuantum;
+	std::shared_ptr<WaitStrategy const> pWaitStrategy;
+
+	mutable std::mutex mSlotsMutex;
+	SlotList mSlots;
+	std::atomic<size_t> mVersion;
+	size_t mNextId;
+
+	std::atomic<bool> mRunning;
+	std::vector<std::thread> mWorkers;
+
+	size_t run(Slot &);
+	void work(size_t index);
+	bool onWorker() const;
+};
+
+inline PollerExecutor::PollerExecutor(
+		size_t workers,
+		size_t quantum,
+		std::shared_ptr<WaitStrategy const> waitStrategy) :
+	mQuantum(quantum),
+	pWaitStrategy(waitStrategy),
+	mVersion(0),
+	mNextId(0),
+	mRunning(true)
+{
+	if (workers == 0 || quantum == 0)
+		throw std::invalid_argument("Empty worker pool");
+
+	if (!pWaitStrategy)
+		throw std::invalid_argument("Empty wait strategy");
+
+	for (size_t i = 0; i < workers; ++i)
+		mWorkers.emplace_back(&PollerExecutor::work, this, i);
+}
+
+inline PollerExecutor::~PollerExecutor()
+{
+	mRunning.store(false);
+
+	for (auto & worker : mWorkers)
+		worker.join();
+}
+
+inline size_t PollerExecutor::add(Task task, size_t weight)
+{
+	if (!task)
+		throw std::invalid_argument("Empty task");
+
+	if (weight == 0)
+		throw std::invalid_argument("Empty task weight");
+
+	std::lock_guard<std::mutex> lock(mSlotsMutex);
+
+	auto id = mNextId++;
+	mSlots.push_back(std::make_shared<Slot>(id, std::move(task), weight));
+	mVersion.fetch_add(1, std::memory_order_release);
+
+	return id;
+}
+
+inline void PollerExecutor::remove(size_t id)
+{
+	std::shared_ptr<Slot> slot;
+
+	{
+		std::lock_guard<std::mutex> lock(mSlotsMutex);
+
+		auto iSlot = std::find_if(mSlots.begin(), mSlots.end(),
+				[id](std::shared_ptr<Slot> const& slot)
+				{
+					return slot->id == id;
+				});
+
+		if (iSlot == mSlots.end())
+			return;
+
+		slot = *iSlot;
+		mSlots.erase(iSlot);
+		mVersion.fetch_add(1, std::memory_order_release);
+	}
+
+	slot->removed.store(true);
+
+	// the calling task may be the one running, or wait on the caller in turn
+	if (onWorker())
+		return;
+
+	// a worker may have claimed it before it was marked
+	while (slot->running.load())
+		std::this_thread::yield();
+}
+
+inline size_t PollerExecutor::size() const
+{
+	std::lock_guard<std::mutex> lock(mSlotsMutex);
+	return mSlots.size();
+}
+
+inline size_t PollerExecutor::workers() const
+{
+	return mWorkers.size();
+}
+
+// runs slot if no other worker is, returns number of messages drained
+inline size_t PollerExecutor::run(Slot & slot)
+{
+	if (slot.running.exchange(true))
+		return 0;
+
+	size_t drained = 0;
+
+	if (!slot.removed.load())
+	{
+		try
+		{
+			drained = slot.task(slot.weight * mQuantum);
+		}
+		catch (...)
+		{
+			// tasks report their own errors, a throwing task is dropped
+			slot.removed.store(true);
+		}
+	}
+
+	slot.running.store(false, std::memory_order_release);
+
+	return drained;
+}
+
+inline bool PollerExecutor::onWorker() const
+{
+	auto id = std::this_thread::get_id();
+
+	return std::any_of(mWorkers.begin(), mWorkers.end(),
+			[id](std::thread const& worker)
+			{
+				return worker.get_id() == id;
+			});
+}
+
+inline void PollerExecutor::work(size_t index)
+{
+	SlotList slots;
+	size_t version = ~size_t(0);
+	size_t start = index;
+	size_t idle = 0;
+
+	WaitStrategy::Park park(
+			[](std::chrono::microseconds timeout) -> bool
+			{
+				std::this_thread::sleep_for(timeout);
+				return false;
+			});
+
+	while (mRunning.load())
+	{
+		if (version != mVersion.load(std::memory_order_acquire))
+		{
+			std::lock_guard<std::mutex> lock(mSlotsMutex);
+			slots = mSlots;
+			version = mVersion.load(std::memory_order_relaxed);
+		}
+
+		size_t drained = 0;
+
+		// start each sweep one slot further on, so no slot is always last
+		for (size_t i = 0; i < slots.size(); ++i)
+			drained += run(*slots[(start + i) % slots.size()]);
+
+		++start;
+
+		if (drained != 0)
+			idle = 0;
+		else
+			pWaitStrategy->idle(idle++, park);
+	}
+}
+
+} // namespace queue
+} // namespace tamgef
+
+#endif
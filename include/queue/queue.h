@@ -1,39 +1,208 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <thread>
+
 #include <internal/concurrentqueue/concurrentqueue.h>
+#include <queue/event_count.h>
 #include <queue/iqueue.h>
 
 namespace tamgef
 {
 
-namespace queue 
+namespace queue
+{
+
+/// @brief What a bounded Queue does with elements that don't fit.
+enum class OverflowPolicy
 {
+	DropOldest, // discard queued elements to make room
+	DropNewest, // discard the elements being enqueued
+	Block       // wait for room, discard the elements on timeout
+};
 
 template<typename T>
 class Queue : public IQueue<T>
 {
 public:
-	T dequeue() override;
+	Queue();
+	Queue(Queue<T> const&) = delete;
+
+	// bounded queue holding at most capacity elements
+	Queue(size_t capacity,
+			OverflowPolicy = OverflowPolicy::DropOldest,
+			std::chrono::microseconds blockTimeout =
+				std::chrono::microseconds::zero());
+
 	bool empty() const override;
 	void enqueue(T element) override;
 	size_t size() const override;
+	bool tryDequeue(T &) override;
+
+	void enqueueBulk(T const*, size_t) override;
+	size_t tryDequeueBulk(T*, size_t) override;
+	size_t tryDequeueBulkInto(T*, size_t) override;
+	bool wait(std::chrono::microseconds) override;
+
+	std::unique_ptr<typename IQueue<T>::Producer> producer() override;
+	std::unique_ptr<typename IQueue<T>::Consumer> consumer() override;
+
+	size_t drops() const override;
+	size_t overflows() const override;
+
+	// returns 0 if unbounded
+	size_t capacity() const;
 
 private:
+	class TokenProducer;
+	class TokenConsumer;
+
+	// output iterator throwing away whatever is written through it
+	struct Discard
+	{
+		Discard & operator*() { return *this; }
+		Discard & operator++() { return *this; }
+		Discard operator++(int) { return *this; }
+
+		template<typename U>
+		Discard & operator=(U &&) { return *this; }
+	};
+
+	// output iterator constructing what is written through it in place
+	struct Construct
+	{
+		T* element;
+
+		Construct & operator*() { return *this; }
+		Construct & operator++() { ++element; return *this; }
+		Construct operator++(int) { return Construct{ element++ }; }
+
+		Construct & operator=(T && value)
+		{
+			::new (element) T(std::move(value));
+			return *this;
+		}
+	};
+
 	moodycamel::ConcurrentQueue<T> mQueue;
+
+	size_t const mCapacity;
+	OverflowPolicy const mPolicy;
+	std::chrono::microseconds const mBlockTimeout;
+
+	std::atomic<size_t> mCount;
+	std::atomic<size_t> mDrops;
+	std::atomic<size_t> mOverflows;
+	EventCount mNotEmpty;
+	EventCount mNotFull;
+
+	size_t admit(size_t count);
+	void evict();
+	void release(size_t count);
+	size_t reserve(size_t count);
+
+	template<typename Enqueue>
+	void insert(T const* elements, size_t count, Enqueue);
 };
 
+/// @brief Producer session holding a moodycamel::ProducerToken.
 template<typename T>
-T Queue<T>::dequeue()
+class Queue<T>::TokenProducer : public IQueue<T>::Producer
 {
-	T element = T();
-	mQueue.try_dequeue(element);
+public:
+	TokenProducer(Queue<T> & queue) :
+		mQueue(queue),
+		mToken(queue.mQueue)
+	{}
 
-	return element;
-}
+	void enqueue(T element) override
+	{
+		if (mQueue.admit(1) == 1)
+		{
+			mQueue.mQueue.enqueue(mToken, std::move(element));
+			mQueue.mNotEmpty.notifyAll();
+		}
+	}
+
+	void enqueueBulk(T const* elements, size_t count) override
+	{
+		mQueue.insert(elements, count,
+				[this](T const* first, size_t admitted)
+				{
+					mQueue.mQueue.enqueue_bulk(mToken, first, admitted);
+				});
+	}
+
+private:
+	Queue<T> & mQueue;
+	moodycamel::ProducerToken mToken;
+};
+
+/// @brief Consumer session holding a moodycamel::ConsumerToken.
+template<typename T>
+class Queue<T>::TokenConsumer : public IQueue<T>::Consumer
+{
+public:
+	TokenConsumer(Queue<T> & queue) :
+		mQueue(queue),
+		mToken(queue.mQueue)
+	{}
+
+	bool tryDequeue(T & element) override
+	{
+		if (!mQueue.mQueue.try_dequeue(mToken, element))
+			return false;
+
+		mQueue.release(1);
+		return true;
+	}
+
+	size_t tryDequeueBulk(T* elements, size_t max) override
+	{
+		auto count = mQueue.mQueue.try_dequeue_bulk(mToken, elements, max);
+		mQueue.release(count);
+
+		return count;
+	}
+
+	size_t tryDequeueBulkInto(T* storage, size_t max) override
+	{
+		auto count = mQueue.mQueue.try_dequeue_bulk(
+				mToken, Construct{ storage }, max);
+		mQueue.release(count);
+
+		return count;
+	}
+
+private:
+	Queue<T> & mQueue;
+	moodycamel::ConsumerToken mToken;
+};
 
 template<typename T>
-bool Queue<T>::empty() const 
+Queue<T>::Queue() :
+	Queue(0)
+{}
+
+template<typename T>
+Queue<T>::Queue(
+		size_t capacity,
+		OverflowPolicy policy,
+		std::chrono::microseconds blockTimeout) :
+	mCapacity(capacity),
+	mPolicy(policy),
+	mBlockTimeout(blockTimeout),
+	mCount(0),
+	mDrops(0),
+	mOverflows(0)
+{}
+
+template<typename T>
+bool Queue<T>::empty() const
 {
 	return size() == 0;
 }
@@ -41,7 +210,11 @@ bool Queue<T>::empty() const
 template<typename T>
 void Queue<T>::enqueue(T element)
 {
-	mQueue.enqueue(element);
+	if (admit(1) == 1)
+	{
+		mQueue.enqueue(std::move(element));
+		mNotEmpty.notifyAll();
+	}
 }
 
 template<typename T>
@@ -50,6 +223,199 @@ size_t Queue<T>::size() const
 	return mQueue.size_approx();
 }
 
+template<typename T>
+bool Queue<T>::tryDequeue(T & element)
+{
+	if (!mQueue.try_dequeue(element))
+		return false;
+
+	release(1);
+	return true;
+}
+
+template<typename T>
+void Queue<T>::enqueueBulk(T const* elements, size_t count)
+{
+	insert(elements, count,
+			[this](T const* first, size_t admitted)
+			{
+				mQueue.enqueue_bulk(first, admitted);
+			});
+}
+
+template<typename T>
+size_t Queue<T>::tryDequeueBulk(T* elements, size_t max)
+{
+	auto count = mQueue.try_dequeue_bulk(elements, max);
+	release(count);
+
+	return count;
+}
+
+template<typename T>
+size_t Queue<T>::tryDequeueBulkInto(T* storage, size_t max)
+{
+	auto count = mQueue.try_dequeue_bulk(Construct{ storage }, max);
+	release(count);
+
+	return count;
+}
+
+template<typename T>
+bool Queue<T>::wait(std::chrono::microseconds timeout)
+{
+	return mNotEmpty.waitFor(
+			[this]() -> bool
+			{
+				return !empty();
+			}, 
+			timeout);
+}
+
+template<typename T>
+std::unique_ptr<typename IQueue<T>::Producer> Queue<T>::producer()
+{
+	return std::unique_ptr<typename IQueue<T>::Producer>(
+			new TokenProducer(*this));
+}
+
+template<typename T>
+std::unique_ptr<typename IQueue<T>::Consumer> Queue<T>::consumer()
+{
+	return std::unique_ptr<typename IQueue<T>::Consumer>(
+			new TokenConsumer(*this));
+}
+
+template<typename T>
+size_t Queue<T>::drops() const
+{
+	return mDrops.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+size_t Queue<T>::overflows() const
+{
+	return mOverflows.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+size_t Queue<T>::capacity() const
+{
+	return mCapacity;
+}
+
+// returns how many of count elements may be enqueued, applying the
+// overflow policy to the rest
+template<typename T>
+size_t Queue<T>::admit(size_t count)
+{
+	if (mCapacity == 0)
+		return count;
+
+	auto admitted = reserve(count);
+
+	if (admitted == count)
+		return count;
+
+	auto requested = count;
+	mOverflows.fetch_add(1, std::memory_order_relaxed);
+
+	switch (mPolicy)
+	{
+	case OverflowPolicy::DropOldest:
+		// a batch larger than capacity keeps only its newest elements
+		count = std::min(count, mCapacity);
+
+		while (admitted < count)
+		{
+			evict();
+			admitted += reserve(count - admitted);
+		}
+		break;
+
+	case OverflowPolicy::DropNewest:
+		break;
+
+	case OverflowPolicy::Block:
+		mNotFull.waitFor(
+				[&]() -> bool
+				{
+					admitted += reserve(count - admitted);
+					return admitted == count;
+				},
+				mBlockTimeout);
+		break;
+	}
+
+	mDrops.fetch_add(requested - admitted, std::memory_order_relaxed);
+
+	return admitted;
+}
+
+// discards the oldest element to make room for a new one
+template<typename T>
+void Queue<T>::evict()
+{
+	if (mQueue.try_dequeue_bulk(Discard(), 1) == 1)
+	{
+		mCount.fetch_sub(1, std::memory_order_relaxed);
+		mDrops.fetch_add(1, std::memory_order_relaxed);
+	}
+	else // reserved by a producer but not enqueued yet
+		std::this_thread::yield();
+}
+
+template<typename T>
+void Queue<T>::release(size_t count)
+{
+	if (mCapacity == 0 || count == 0)
+		return;
+
+	mCount.fetch_sub(count, std::memory_order_relaxed);
+
+	if (mPolicy == OverflowPolicy::Block)
+		mNotFull.notifyAll();
+}
+
+// claims up to count free slots, returns number claimed
+template<typename T>
+size_t Queue<T>::reserve(size_t count)
+{
+	auto current = mCount.load(std::memory_order_relaxed);
+	size_t claimed;
+
+	do
+	{
+		claimed = std::min(count, mCapacity - std::min(current, mCapacity));
+
+		if (claimed == 0)
+			return 0;
+	}
+	while (!mCount.compare_exchange_weak(current, current + claimed,
+				std::memory_order_relaxed));
+
+	return claimed;
+}
+
+// enqueues the admitted part of a bulk insert, for DropOldest those are
+// the last elements, otherwise the first
+template<typename T>
+template<typename Enqueue>
+void Queue<T>::insert(T const* elements, size_t count, Enqueue enqueue)
+{
+	auto admitted = admit(count);
+
+	if (admitted == 0)
+		return;
+
+	if (mPolicy == OverflowPolicy::DropOldest)
+		enqueue(elements + (count - admitted), admitted);
+	else
+		enqueue(elements, admitted);
+
+	mNotEmpty.notifyAll();
+}
+
 } // namespace queue
 } // namespace tamgef
 
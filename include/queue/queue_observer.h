@@ -28,7 +28,15 @@ public:
 			std::initializer_list<std::shared_ptr<observer::IObserver<T>>>
 		);
 
-	virtual ~QueueObserver();
+	// notifies observers from the executor's workers
+	QueueObserver(
+			QueueReader<T>, 
+			std::initializer_list<std::shared_ptr<observer::IObserver<T>>>,
+			PollerExecutor &,
+			size_t weight = 1
+		);
+
+	virtual ~QueueObserver() = default;
 
 	void attachObserver(std::shared_ptr<observer::IObserver<T>>);
 	void detachObserver(std::shared_ptr<observer::IObserver<T>>);
@@ -46,7 +54,22 @@ QueueObserver(QueueReader<T> queueReader,
 	mObservable(observers),
 	mQueuePoller(queueReader, 
 			std::bind(&observer::Observable<T>::notifyObservers, 
-				std::ref(mObservable))
+				std::ref(mObservable), std::placeholders::_1)
+		)
+{}
+
+template<typename T>
+QueueObserver<T>::
+QueueObserver(QueueReader<T> queueReader,
+		std::initializer_list<std::shared_ptr<observer::IObserver<T>>> observers,
+		PollerExecutor & executor,
+		size_t weight) :
+	mObservable(observers),
+	mQueuePoller(queueReader, 
+			std::bind(&observer::Observable<T>::notifyObservers, 
+				std::ref(mObservable), std::placeholders::_1),
+			executor,
+			weight
 		)
 {}
 
@@ -1,7 +1,9 @@
 #ifndef QUEUE_POLLER_H
 #define QUEUE_POLLER_H
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <exception>
 #include <functional>
 #include <map>
@@ -10,7 +12,10 @@
 #include <stdexcept>
 #include <thread>
 
+#include <queue/element_buffer.h>
+#include <queue/poller_executor.h>
 #include <queue/queue_reader.h>
+#include <queue/wait_strategy.h>
 
 namespace tamgef {
 namespace queue {
@@ -19,12 +24,35 @@ template<typename T>
 class QueuePoller
 {
 public:
+	/// @brief Handles count consecutive messages starting at first.
+	typedef std::function<void(T const* first, size_t count)> BatchHandler;
+
 	QueuePoller(QueuePoller<T> const&);
 	QueuePoller(QueuePoller<T> &&);
-	QueuePoller(QueueReader<T> const&, std::function<void(T)>);
+	QueuePoller(QueueReader<T> const&, std::function<void(T)>,
+			std::shared_ptr<WaitStrategy const> = 
+				std::make_shared<AdaptiveWait>());
+
+	// polls on the executor's workers instead of an own thread
+	// the executor must outlive the poller
+	QueuePoller(QueueReader<T> const&, std::function<void(T)>,
+			PollerExecutor &, size_t weight = 1);
+
+	// drains up to maxBatch messages per call to the handler
+	// batches grow with queue depth, a batch short of its target size
+	// waits at most maxLatency for more messages before it's handled
+	QueuePoller(QueueReader<T> const&, BatchHandler,
+			size_t maxBatch,
+			std::chrono::microseconds maxLatency = 
+				std::chrono::microseconds::zero(),
+			std::shared_ptr<WaitStrategy const> = 
+				std::make_shared<AdaptiveWait>());
 	virtual ~QueuePoller();
 
 	std::exception_ptr error();
+
+	// returns number of times the queue was found empty
+	size_t idleSpins() const;
 	bool polling() const;
 	void stop();
 
@@ -33,16 +61,39 @@ private:
 		checkQueueReader(QueueReader<T> const&);
 	static std::function<void(T)> 
 		checkHandler(std::function<void(T)>);
+	static BatchHandler
+		checkHandler(BatchHandler);
+	static size_t 
+		checkMaxBatch(size_t);
+	static std::shared_ptr<WaitStrategy const>
+		checkWaitStrategy(std::shared_ptr<WaitStrategy const>);
+	static QueuePoller<T> const&
+		checkCopyable(QueuePoller<T> const&);
 
 	QueueReader<T> mQueueReader;
 
 	std::atomic<bool> mPolling;
+	std::atomic<size_t> mIdleSpins;
 	std::function<void(T)> mHandler;
+	BatchHandler mBatchHandler;
+	size_t mMaxBatch;
+	std::chrono::microseconds mMaxLatency;
+	std::shared_ptr<WaitStrategy const> pWaitStrategy;
 	std::mutex mExceptionMutex;
 	std::exception_ptr mException;
+
+	PollerExecutor * pExecutor;
+	size_t mWeight;
+	size_t mTaskId;
+	std::unique_ptr<typename QueueReader<T>::Consumer> pConsumer;
+	ElementBuffer<T> mMessage;
 	std::thread mThread;
 
+	size_t drain(size_t budget);
+	void fail();
 	void poll();
+	void pollBatch(typename QueueReader<T>::Consumer &, WaitStrategy::Park const&);
+	void pollEach(typename QueueReader<T>::Consumer &, WaitStrategy::Park const&);
 };
 
 template<typename T>
@@ -65,35 +116,167 @@ checkHandler(std::function<void(T)> handler)
 	return handler;
 }
 
+template<typename T>
+typename QueuePoller<T>::BatchHandler QueuePoller<T>::
+checkHandler(BatchHandler handler)
+{
+	if (!handler)
+		throw std::invalid_argument("Empty function handler");
+
+	return handler;
+}
+
+template<typename T>
+size_t QueuePoller<T>::checkMaxBatch(size_t maxBatch)
+{
+	if (maxBatch == 0)
+		throw std::invalid_argument("Empty batch size");
+
+	return maxBatch;
+}
+
+template<typename T>
+std::shared_ptr<WaitStrategy const> QueuePoller<T>::
+checkWaitStrategy(std::shared_ptr<WaitStrategy const> waitStrategy)
+{
+	if (!waitStrategy)
+		throw std::invalid_argument("Empty wait strategy");
+
+	return waitStrategy;
+}
+
+template<typename T>
+QueuePoller<T> const& QueuePoller<T>::
+checkCopyable(QueuePoller<T> const& other)
+{
+	if (other.pExecutor)
+		throw std::logic_error("Executor poller not copyable");
+
+	return other;
+}
+
 template<typename T>
 QueuePoller<T>::QueuePoller(
 		QueueReader<T> const& queueReader, 
-		std::function<void(T)> handler) :
-	mPolling(true),
+		std::function<void(T)> handler,
+		std::shared_ptr<WaitStrategy const> waitStrategy) :
 	mQueueReader(checkQueueReader(queueReader)),
+	mPolling(true),
+	mIdleSpins(0),
 	mHandler(checkHandler(handler)),
+	mMaxBatch(0),
+	mMaxLatency(std::chrono::microseconds::zero()),
+	pWaitStrategy(checkWaitStrategy(waitStrategy)),
+	pExecutor(nullptr),
+	mWeight(0),
+	mTaskId(0),
 	mThread(&QueuePoller<T>::poll, this)
 {}
 
+template<typename T>
+QueuePoller<T>::QueuePoller(
+		QueueReader<T> const& queueReader, 
+		BatchHandler handler,
+		size_t maxBatch,
+		std::chrono::microseconds maxLatency,
+		std::shared_ptr<WaitStrategy const> waitStrategy) :
+	mQueueReader(checkQueueReader(queueReader)),
+	mPolling(true),
+	mIdleSpins(0),
+	mBatchHandler(checkHandler(handler)),
+	mMaxBatch(checkMaxBatch(maxBatch)),
+	mMaxLatency(maxLatency),
+	pWaitStrategy(checkWaitStrategy(waitStrategy)),
+	pExecutor(nullptr),
+	mWeight(0),
+	mTaskId(0),
+	mThread(&QueuePoller<T>::poll, this)
+{}
+
+template<typename T>
+QueuePoller<T>::QueuePoller(
+		QueueReader<T> const& queueReader, 
+		std::function<void(T)> handler,
+		PollerExecutor & executor,
+		size_t weight) :
+	mQueueReader(checkQueueReader(queueReader)),
+	mPolling(true),
+	mIdleSpins(0),
+	mHandler(checkHandler(handler)),
+	mMaxBatch(0),
+	mMaxLatency(std::chrono::microseconds::zero()),
+	pWaitStrategy(nullptr),
+	pExecutor(&executor),
+	mWeight(weight),
+	mTaskId(0)
+{
+	// workers may call drain() as soon as it's added
+	mTaskId = executor.add(
+			std::bind(&QueuePoller<T>::drain, this, std::placeholders::_1),
+			weight);
+}
+
 template<typename T>
 QueuePoller<T>::QueuePoller(QueuePoller<T> const& other) :
-	QueuePoller(other.mQueueReader, other.mHandler)
+	mQueueReader(checkCopyable(other).mQueueReader),
+	mPolling(true),
+	mIdleSpins(0),
+	mHandler(other.mHandler),
+	mBatchHandler(other.mBatchHandler),
+	mMaxBatch(other.mMaxBatch),
+	mMaxLatency(other.mMaxLatency),
+	pWaitStrategy(other.pWaitStrategy),
+	pExecutor(nullptr),
+	mWeight(0),
+	mTaskId(0),
+	mThread(&QueuePoller<T>::poll, this)
 {}
 
 template<typename T>
 QueuePoller<T>::QueuePoller(QueuePoller<T> && other) :
 	mQueueReader(std::move(other.mQueueReader)),
 	mPolling(other.mPolling.load()),
+	mIdleSpins(other.mIdleSpins.load()),
 	mHandler(std::move(other.mHandler)),
-	mThread(std::move(other.mThread)),
-	mException(std::move(other.mException))
-{}
+	mBatchHandler(std::move(other.mBatchHandler)),
+	mMaxBatch(other.mMaxBatch),
+	mMaxLatency(other.mMaxLatency),
+	pWaitStrategy(std::move(other.pWaitStrategy)),
+	mException(std::move(other.mException)),
+	pExecutor(other.pExecutor),
+	mWeight(other.mWeight),
+	mTaskId(0),
+	mThread(std::move(other.mThread))
+{
+	// the task is bound to other, rebind it to this
+	if (pExecutor)
+	{
+		pExecutor->remove(other.mTaskId);
+		other.pExecutor = nullptr;
+
+		pConsumer = std::move(other.pConsumer);
+		mTaskId = pExecutor->add(
+				std::bind(&QueuePoller<T>::drain, this, std::placeholders::_1),
+				mWeight);
+	}
+}
 
 template<typename T>
 QueuePoller<T>::~QueuePoller()
 {
 	mPolling.store(false);
-	mThread.join();
+
+	if (pExecutor)
+		pExecutor->remove(mTaskId);
+
+	if (mThread.joinable())
+		mThread.join();
+}
+
+template<typename T>
+size_t QueuePoller<T>::idleSpins() const
+{
+	return mIdleSpins.load(std::memory_order_relaxed);
 }
 
 template<typename T>
@@ -102,6 +285,12 @@ bool QueuePoller<T>::polling() const
 	return mPolling.load();
 }
 
+template<typename T>
+void QueuePoller<T>::stop()
+{
+	mPolling.store(false);
+}
+
 template<typename T>
 std::exception_ptr QueuePoller<T>::error()
 {
@@ -109,29 +298,168 @@ std::exception_ptr QueuePoller<T>::error()
 	return mException;
 }
 
+// executor task, runs on one worker at a time
+template<typename T>
+size_t QueuePoller<T>::drain(size_t budget)
+{
+	if (!polling())
+		return 0;
+
+	size_t count = 0;
+
+	try
+	{
+		if (!pConsumer)
+			pConsumer.reset(new typename QueueReader<T>::Consumer(
+						mQueueReader.consumer()));
+
+		auto pinned = pConsumer->pin();
+		mMessage.reserve(1);
+
+		// messages are constructed in place, T needs no default constructor
+		while (count < budget && mMessage.fill(pinned, 1) == 1)
+		{
+			mHandler(std::move(*mMessage.data()));
+			mMessage.clear();
+			++count;
+		}
+
+		if (count == 0)
+			mIdleSpins.store(mIdleSpins.load(std::memory_order_relaxed) + 1,
+					std::memory_order_relaxed);
+	}
+	catch (...)
+	{
+		fail();
+	}
+
+	return count;
+}
+
+template<typename T>
+void QueuePoller<T>::fail()
+{
+	{
+		std::lock_guard<std::mutex> lock(mExceptionMutex);
+		mException = std::current_exception();
+	}
+
+	mPolling.store(false);
+}
+
 template<typename T>
 void QueuePoller<T>::poll()
 {
+	try 
+	{
+		auto consumer = mQueueReader.consumer();
+		WaitStrategy::Park park(
+				[&consumer](std::chrono::microseconds timeout) -> bool
+				{
+					return consumer.wait(timeout);
+				});
+
+		if (mBatchHandler)
+			pollBatch(consumer, park);
+		else
+			pollEach(consumer, park);
+	}
+	catch (...)
+	{
+		fail();
+	}
+}
+
+template<typename T>
+void QueuePoller<T>::pollBatch(
+		typename QueueReader<T>::Consumer & consumer,
+		WaitStrategy::Park const& park)
+{
+	ElementBuffer<T> batch(mMaxBatch);
+	size_t target = 1;
+	size_t idle = 0;
+
 	while (polling())
 	{
-		try 
+		size_t count = 0;
+
 		{
-			if (!mQueueReader.empty()) 
+			// held for one batch, expiry is detected on the next pin
+			auto pinned = consumer.pin();
+			count = batch.fill(pinned, mMaxBatch);
+
+			if (count != 0 && count < target && mMaxLatency.count() != 0)
 			{
-				T message = mQueueReader.dequeue();
-				mHandler(message);
+				auto deadline = std::chrono::steady_clock::now() + mMaxLatency;
+
+				do
+				{
+					auto topUp = batch.fill(pinned, target - count);
+
+					if (topUp == 0)
+						std::this_thread::yield();
+
+					count += topUp;
+				}
+				while (count < target && 
+						std::chrono::steady_clock::now() < deadline);
 			}
-			else
-				std::this_thread::yield();
 		}
-		catch (...)
+
+		if (count == 0)
+		{
+			mIdleSpins.store(mIdleSpins.load(std::memory_order_relaxed) + 1,
+					std::memory_order_relaxed);
+			pWaitStrategy->idle(idle++, park);
+			continue;
+		}
+
+		idle = 0;
+		mBatchHandler(batch.data(), count);
+		batch.clear();
+
+		// a full batch means the queue is backing up, jump to the maximum,
+		// otherwise follow the depth down
+		if (count == mMaxBatch)
+			target = mMaxBatch;
+		else
+			target = std::max<size_t>(1, (target + count) / 2);
+	}
+}
+
+template<typename T>
+void QueuePoller<T>::pollEach(
+		typename QueueReader<T>::Consumer & consumer,
+		WaitStrategy::Park const& park)
+{
+	ElementBuffer<T> message(1);
+	size_t idle = 0;
+
+	while (polling())
+	{
+		size_t count = 0;
+
 		{
+			// held until the queue is drained, expiry is detected on the
+			// next pin
+			auto pinned = consumer.pin();
+
+			while (polling() && message.fill(pinned, 1) == 1)
 			{
-				std::lock_guard<std::mutex> lock(mExceptionMutex);
-				mException = std::current_exception();
+				mHandler(std::move(*message.data()));
+				message.clear();
+				++count;
 			}
+		}
 
-			mPolling.store(false);
+		if (count != 0)
+			idle = 0;
+		else
+		{
+			// only written by this thread
+			mIdleSpins.store(mIdleSpins.load(std::memory_order_relaxed) + 1,
+					std::memory_order_relaxed);
+			pWaitStrategy->idle(idle++, park);
 		}
 	}
 }
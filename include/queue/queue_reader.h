@@ -1,7 +1,9 @@
 #ifndef QUEUE_READER_H
 #define QUEUE_READER_H
 
+#include <chrono>
 #include <memory>
+#include <stdexcept>
 
 #include <queue/iqueue.h>
 
@@ -12,32 +14,100 @@ template<typename T>
 class QueueReader
 {
 public:
+	/// @brief Scoped strong reference to the queue connected to a reader.
+	/// @details Keeps the queue alive for its lifetime, so a batch or poll
+	/// loop pays for one weak_ptr lock instead of one per call. Expiry is
+	/// only detected when pinning.
+	class PinnedSession
+	{
+	public:
+		PinnedSession(std::shared_ptr<IQueue<T>>, 
+				typename IQueue<T>::Consumer * = nullptr);
+
+		bool empty() const;
+		size_t size() const;
+		bool tryDequeue(T &);
+		size_t tryDequeueBulk(T*, size_t);
+		size_t tryDequeueBulkInto(T*, size_t);
+
+		// read elements in place, only through a Consumer's session
+		// throw std::logic_error if the queue doesn't lend elements
+		size_t view(T const*&);
+		void release(size_t);
+
+	private:
+		std::shared_ptr<IQueue<T>> pQueue;
+		typename IQueue<T>::Consumer * pConsumer;
+	};
+
+	/// @brief Consumer session on the queue connected to a reader.
+	/// @details Dequeues through the queue's own consumer session, 
+	/// so must only be used by one thread at a time.
+	class Consumer
+	{
+	public:
+		Consumer(std::shared_ptr<IQueue<T>> const&);
+
+		bool expired() const;
+		// throws std::runtime_error if the queue has expired
+		PinnedSession pin() const;
+		bool tryDequeue(T &);
+		size_t tryDequeueBulk(T*, size_t);
+		bool wait(std::chrono::microseconds);
+
+		// points first at unread elements to be read in place, they stay
+		// valid until released, e.g. slots of a RingQueue
+		// throw std::logic_error if the queue doesn't lend elements
+		size_t view(T const*& first);
+		void release(size_t count);
+
+	private:
+		std::weak_ptr<IQueue<T>> pQueue;
+		std::unique_ptr<typename IQueue<T>::Consumer> pConsumer;
+	};
+
 	QueueReader() = default;
 	QueueReader(QueueReader<T> const&);
 	QueueReader(QueueReader<T> &&);
 	QueueReader<T> & operator=(QueueReader<T>);
 
+	// readers are counted by the queue they're connected to
 	QueueReader(std::shared_ptr<IQueue<T>>);
-	virtual ~QueueReader() = default;
+	virtual ~QueueReader();
 
 	void connect(std::shared_ptr<IQueue<T>>);
+	Consumer consumer() const;
 	T dequeue();
 	void disconnect();
+	size_t drops() const;
 	bool empty() const;
 	bool expired() const;
+	size_t overflows() const;
+	// throws std::runtime_error if the queue has expired
+	PinnedSession pin() const;
 	size_t size() const;
+	bool tryDequeue(T &);
+	size_t tryDequeueBulk(T*, size_t);
+	bool wait(std::chrono::microseconds);
 
 	void swap(QueueReader<T> &);
 
 private:
 	std::weak_ptr<IQueue<T>> pQueue;
 
+	static std::shared_ptr<IQueue<T>> subscribe(std::shared_ptr<IQueue<T>>);
+
+	void attach();
+	void detach();
+
 };// class QueueReader
 
 template<typename T>
 QueueReader<T>::QueueReader(QueueReader<T> const& other) :
 	pQueue(other.pQueue)
-{}
+{
+	attach();
+}
 
 template<typename T>
 QueueReader<T>::QueueReader(QueueReader<T> && other)
@@ -54,8 +124,16 @@ QueueReader<T> & QueueReader<T>::operator=(QueueReader<T> other)
 
 template<typename T>
 QueueReader<T>::QueueReader(std::shared_ptr<IQueue<T>> queue) :
-	pQueue(queue)
-{}
+	pQueue(subscribe(std::move(queue)))
+{
+	attach();
+}
+
+template<typename T>
+QueueReader<T>::~QueueReader()
+{
+	detach();
+}
 
 template<typename T>
 void QueueReader<T>::connect(std::shared_ptr<IQueue<T>> queue)
@@ -63,24 +141,51 @@ void QueueReader<T>::connect(std::shared_ptr<IQueue<T>> queue)
 	if (!queue)
 		throw std::invalid_argument("Queue reference empty");
 
-	pQueue = queue;
+	detach();
+	pQueue = subscribe(std::move(queue));
+	attach();
+}
+
+template<typename T>
+typename QueueReader<T>::Consumer QueueReader<T>::consumer() const
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return Consumer(queue);
 }
 
 template<typename T>
 T QueueReader<T>::dequeue()
 {
-	if (expired())
+	auto queue = pQueue.lock();
+
+	if (!queue)
 		throw std::runtime_error("Queue reference expired");
 
-	return pQueue.lock()->dequeue();
+	return queue->dequeue();
 }
 
 template<typename T>
 void QueueReader<T>::disconnect()
 {
+	detach();
 	pQueue.reset();
 }
 
+template<typename T>
+size_t QueueReader<T>::drops() const
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return queue->drops();
+}
+
 template<typename T>
 bool QueueReader<T>::empty() const
 {
@@ -96,6 +201,28 @@ bool QueueReader<T>::expired() const
 	return pQueue.expired();
 }
 
+template<typename T>
+size_t QueueReader<T>::overflows() const
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return queue->overflows();
+}
+
+template<typename T>
+typename QueueReader<T>::PinnedSession QueueReader<T>::pin() const
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return PinnedSession(std::move(queue));
+}
+
 template<typename T>
 size_t QueueReader<T>::size() const
 {
@@ -105,12 +232,215 @@ size_t QueueReader<T>::size() const
 	return pQueue.lock()->size();
 }
 
+template<typename T>
+bool QueueReader<T>::tryDequeue(T & element)
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return queue->tryDequeue(element);
+}
+
+template<typename T>
+size_t QueueReader<T>::tryDequeueBulk(T* elements, size_t max)
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return queue->tryDequeueBulk(elements, max);
+}
+
+template<typename T>
+bool QueueReader<T>::wait(std::chrono::microseconds timeout)
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return queue->wait(timeout);
+}
+
 template<typename T>
 void QueueReader<T>::swap(QueueReader<T> & other)
 {
 	std::swap(pQueue, other.pQueue);
 }
 
+template<typename T>
+void QueueReader<T>::attach()
+{
+	if (auto queue = pQueue.lock())
+		queue->attachReader();
+}
+
+template<typename T>
+void QueueReader<T>::detach()
+{
+	if (auto queue = pQueue.lock())
+		queue->detachReader();
+}
+
+// copies of a reader share the queue it subscribed to
+template<typename T>
+std::shared_ptr<IQueue<T>> QueueReader<T>::
+subscribe(std::shared_ptr<IQueue<T>> queue)
+{
+	if (!queue)
+		return queue;
+
+	auto subscription = queue->subscribe();
+
+	return subscription ? subscription : queue;
+}
+
+template<typename T>
+QueueReader<T>::Consumer::Consumer(std::shared_ptr<IQueue<T>> const& queue) :
+	pQueue(queue),
+	pConsumer(queue->consumer())
+{}
+
+template<typename T>
+bool QueueReader<T>::Consumer::expired() const
+{
+	return pQueue.expired();
+}
+
+template<typename T>
+typename QueueReader<T>::PinnedSession QueueReader<T>::Consumer::pin() const
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return PinnedSession(std::move(queue), pConsumer.get());
+}
+
+template<typename T>
+bool QueueReader<T>::Consumer::tryDequeue(T & element)
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return pConsumer->tryDequeue(element);
+}
+
+template<typename T>
+size_t QueueReader<T>::Consumer::tryDequeueBulk(T* elements, size_t max)
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return pConsumer->tryDequeueBulk(elements, max);
+}
+
+template<typename T>
+size_t QueueReader<T>::Consumer::view(T const*& first)
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return pConsumer->view(first);
+}
+
+template<typename T>
+void QueueReader<T>::Consumer::release(size_t count)
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	pConsumer->release(count);
+}
+
+template<typename T>
+bool QueueReader<T>::Consumer::wait(std::chrono::microseconds timeout)
+{
+	auto queue = pQueue.lock();
+
+	if (!queue)
+		throw std::runtime_error("Queue reference expired");
+
+	return queue->wait(timeout);
+}
+
+template<typename T>
+QueueReader<T>::PinnedSession::PinnedSession(
+		std::shared_ptr<IQueue<T>> queue,
+		typename IQueue<T>::Consumer * consumer) :
+	pQueue(std::move(queue)),
+	pConsumer(consumer)
+{}
+
+template<typename T>
+bool QueueReader<T>::PinnedSession::empty() const
+{
+	return pQueue->empty();
+}
+
+template<typename T>
+size_t QueueReader<T>::PinnedSession::size() const
+{
+	return pQueue->size();
+}
+
+template<typename T>
+bool QueueReader<T>::PinnedSession::tryDequeue(T & element)
+{
+	if (pConsumer)
+		return pConsumer->tryDequeue(element);
+
+	return pQueue->tryDequeue(element);
+}
+
+template<typename T>
+size_t QueueReader<T>::PinnedSession::tryDequeueBulk(T* elements, size_t max)
+{
+	if (pConsumer)
+		return pConsumer->tryDequeueBulk(elements, max);
+
+	return pQueue->tryDequeueBulk(elements, max);
+}
+
+template<typename T>
+size_t QueueReader<T>::PinnedSession::view(T const*& first)
+{
+	if (!pConsumer)
+		throw std::logic_error("Views need a consumer session");
+
+	return pConsumer->view(first);
+}
+
+template<typename T>
+void QueueReader<T>::PinnedSession::release(size_t count)
+{
+	if (!pConsumer)
+		throw std::logic_error("Views need a consumer session");
+
+	pConsumer->release(count);
+}
+
+template<typename T>
+size_t QueueReader<T>::PinnedSession::tryDequeueBulkInto(T* storage, size_t max)
+{
+	if (pConsumer)
+		return pConsumer->tryDequeueBulkInto(storage, max);
+
+	return pQueue->tryDequeueBulkInto(storage, max);
+}
+
 } // namespace queue
 } // namespace tamgef
 
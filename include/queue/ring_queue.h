@@ -0,0 +1,411 @@
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include <queue/event_count.h>
+#include <queue/iqueue.h>
+
+namespace tamgef {
+namespace queue {
+
+/// @brief Wait-free single-producer, single-consumer ring buffer.
+/// @details Capacity is rounded up to a power of two and allocated once
+/// on construction. Only one thread may enqueue and only one thread may
+/// dequeue at a time; use Queue for anything else.
+template<typename T>
+class RingQueue : public IQueue<T>
+{
+public:
+	RingQueue(size_t capacity);
+	RingQueue(RingQueue<T> const&) = delete;
+
+	bool empty() const override;
+
+	// throws std::overflow_error if the ring is full
+	void enqueue(T element) override;
+	size_t size() const override;
+
+	// throws std::overflow_error if the ring can't hold all elements
+	void enqueueBulk(T const*, size_t) override;
+	bool tryDequeue(T &) override;
+	size_t tryDequeueBulk(T*, size_t) override;
+	size_t tryDequeueBulkInto(T*, size_t) override;
+	bool wait(std::chrono::microseconds) override;
+
+	std::unique_ptr<typename IQueue<T>::Producer> producer() override;
+	std::unique_ptr<typename IQueue<T>::Consumer> consumer() override;
+
+	size_t capacity() const;
+
+	// return false or a short count instead of throwing when full
+	bool tryEnqueue(T element) override;
+	size_t tryEnqueueBulk(T const*, size_t) override;
+
+	// lends the next free slot, or up to max contiguous ones through
+	// first, to be filled in place; returns nullptr or 0 if the ring is
+	// full. Claiming again before committing lends the same slots.
+	T* claim();
+	size_t claim(T*& first, size_t max);
+
+	// publishes count claimed slots
+	void commit(size_t count = 1);
+
+	// points first at the unread elements up to the end of the ring,
+	// returns their number; they stay valid until released
+	size_t view(T const*& first);
+
+	// marks count viewed elements as read, freeing their slots
+	void release(size_t count);
+
+private:
+	class LoaningProducer;
+	class LoaningConsumer;
+
+	static const size_t sCacheLineSize = 64;
+
+	static size_t checkCapacity(size_t);
+
+	size_t const mMask;
+	std::vector<T> mBuffer;
+
+	// consumer owned
+	char mPadding0[sCacheLineSize];
+	std::atomic<size_t> mHead;
+	size_t mCachedTail;
+
+	// producer owned
+	char mPadding1[sCacheLineSize];
+	std::atomic<size_t> mTail;
+	size_t mCachedHead;
+
+	char mPadding2[sCacheLineSize];
+	EventCount mNotEmpty;
+};
+
+/// @brief Producer session lending slots of the ring.
+template<typename T>
+class RingQueue<T>::LoaningProducer : public IQueue<T>::Producer
+{
+public:
+	LoaningProducer(RingQueue<T> & queue) :
+		mQueue(queue)
+	{}
+
+	void enqueue(T element) override
+	{
+		mQueue.enqueue(std::move(element));
+	}
+
+	void enqueueBulk(T const* elements, size_t count) override
+	{
+		mQueue.enqueueBulk(elements, count);
+	}
+
+	bool tryEnqueue(T element) override
+	{
+		return mQueue.tryEnqueue(std::move(element));
+	}
+
+	size_t tryEnqueueBulk(T const* elements, size_t count) override
+	{
+		return mQueue.tryEnqueueBulk(elements, count);
+	}
+
+	T* claim() override
+	{
+		return mQueue.claim();
+	}
+
+	void commit() override
+	{
+		mQueue.commit();
+	}
+
+private:
+	RingQueue<T> & mQueue;
+};
+
+/// @brief Consumer session reading elements of the ring in place.
+template<typename T>
+class RingQueue<T>::LoaningConsumer : public IQueue<T>::Consumer
+{
+public:
+	LoaningConsumer(RingQueue<T> & queue) :
+		mQueue(queue)
+	{}
+
+	bool tryDequeue(T & element) override
+	{
+		return mQueue.tryDequeue(element);
+	}
+
+	size_t tryDequeueBulk(T* elements, size_t max) override
+	{
+		return mQueue.tryDequeueBulk(elements, max);
+	}
+
+	size_t tryDequeueBulkInto(T* storage, size_t max) override
+	{
+		return mQueue.tryDequeueBulkInto(storage, max);
+	}
+
+	size_t view(T const*& first) override
+	{
+		return mQueue.view(first);
+	}
+
+	void release(size_t count) override
+	{
+		mQueue.release(count);
+	}
+
+private:
+	RingQueue<T> & mQueue;
+};
+
+template<typename T>
+size_t RingQueue<T>::checkCapacity(size_t capacity)
+{
+	if (capacity == 0)
+		throw std::invalid_argument("Empty ring capacity");
+
+	size_t powerOfTwo = 1;
+
+	while (powerOfTwo < capacity)
+		powerOfTwo <<= 1;
+
+	return powerOfTwo;
+}
+
+template<typename T>
+RingQueue<T>::RingQueue(size_t capacity) :
+	mMask(checkCapacity(capacity) - 1),
+	mBuffer(mMask + 1),
+	mHead(0),
+	mCachedTail(0),
+	mTail(0),
+	mCachedHead(0)
+{}
+
+template<typename T>
+bool RingQueue<T>::empty() const
+{
+	return size() == 0;
+}
+
+template<typename T>
+void RingQueue<T>::enqueue(T element)
+{
+	if (!tryEnqueue(std::move(element)))
+		throw std::overflow_error("Ring capacity exceeded");
+}
+
+template<typename T>
+size_t RingQueue<T>::size() const
+{
+	auto head = mHead.load(std::memory_order_acquire);
+	auto tail = mTail.load(std::memory_order_acquire);
+
+	return tail - head;
+}
+
+template<typename T>
+void RingQueue<T>::enqueueBulk(T const* elements, size_t count)
+{
+	auto tail = mTail.load(std::memory_order_relaxed);
+
+	if (tail + count - mCachedHead > capacity())
+	{
+		mCachedHead = mHead.load(std::memory_order_acquire);
+
+		if (tail + count - mCachedHead > capacity())
+			throw std::overflow_error("Ring capacity exceeded");
+	}
+
+	for (size_t i = 0; i < count; ++i)
+		mBuffer[(tail + i) & mMask] = elements[i];
+
+	mTail.store(tail + count, std::memory_order_release);
+	mNotEmpty.notifyAll();
+}
+
+template<typename T>
+bool RingQueue<T>::tryDequeue(T & element)
+{
+	return tryDequeueBulk(&element, 1) == 1;
+}
+
+template<typename T>
+size_t RingQueue<T>::tryDequeueBulk(T* elements, size_t max)
+{
+	auto head = mHead.load(std::memory_order_relaxed);
+
+	if (mCachedTail - head < max)
+		mCachedTail = mTail.load(std::memory_order_acquire);
+
+	auto count = std::min(max, mCachedTail - head);
+
+	if (count == 0)
+		return 0;
+
+	for (size_t i = 0; i < count; ++i)
+		elements[i] = std::move(mBuffer[(head + i) & mMask]);
+
+	mHead.store(head + count, std::memory_order_release);
+
+	return count;
+}
+
+template<typename T>
+size_t RingQueue<T>::tryDequeueBulkInto(T* storage, size_t max)
+{
+	auto head = mHead.load(std::memory_order_relaxed);
+
+	if (mCachedTail - head < max)
+		mCachedTail = mTail.load(std::memory_order_acquire);
+
+	auto count = std::min(max, mCachedTail - head);
+
+	for (size_t i = 0; i < count; ++i)
+		::new (storage + i) T(std::move(mBuffer[(head + i) & mMask]));
+
+	if (count != 0)
+		mHead.store(head + count, std::memory_order_release);
+
+	return count;
+}
+
+template<typename T>
+bool RingQueue<T>::wait(std::chrono::microseconds timeout)
+{
+	return mNotEmpty.waitFor(
+			[this]() -> bool
+			{
+				return !empty();
+			}, 
+			timeout);
+}
+
+template<typename T>
+std::unique_ptr<typename IQueue<T>::Producer> RingQueue<T>::producer()
+{
+	return std::unique_ptr<typename IQueue<T>::Producer>(
+			new LoaningProducer(*this));
+}
+
+template<typename T>
+std::unique_ptr<typename IQueue<T>::Consumer> RingQueue<T>::consumer()
+{
+	return std::unique_ptr<typename IQueue<T>::Consumer>(
+			new LoaningConsumer(*this));
+}
+
+template<typename T>
+size_t RingQueue<T>::capacity() const
+{
+	return mMask + 1;
+}
+
+template<typename T>
+bool RingQueue<T>::tryEnqueue(T element)
+{
+	auto tail = mTail.load(std::memory_order_relaxed);
+
+	if (tail - mCachedHead == capacity())
+	{
+		mCachedHead = mHead.load(std::memory_order_acquire);
+
+		if (tail - mCachedHead == capacity())
+			return false;
+	}
+
+	mBuffer[tail & mMask] = std::move(element);
+	mTail.store(tail + 1, std::memory_order_release);
+	mNotEmpty.notifyAll();
+
+	return true;
+}
+
+template<typename T>
+size_t RingQueue<T>::tryEnqueueBulk(T const* elements, size_t count)
+{
+	auto tail = mTail.load(std::memory_order_relaxed);
+
+	if (tail + count - mCachedHead > capacity())
+		mCachedHead = mHead.load(std::memory_order_acquire);
+
+	count = std::min(count, capacity() - (tail - mCachedHead));
+
+	if (count == 0)
+		return 0;
+
+	for (size_t i = 0; i < count; ++i)
+		mBuffer[(tail + i) & mMask] = elements[i];
+
+	mTail.store(tail + count, std::memory_order_release);
+	mNotEmpty.notifyAll();
+
+	return count;
+}
+
+template<typename T>
+T* RingQueue<T>::claim()
+{
+	T* first;
+
+	return claim(first, 1) == 1 ? first : nullptr;
+}
+
+template<typename T>
+size_t RingQueue<T>::claim(T*& first, size_t max)
+{
+	auto tail = mTail.load(std::memory_order_relaxed);
+	auto index = tail & mMask;
+
+	if (tail - mCachedHead + max > capacity())
+		mCachedHead = mHead.load(std::memory_order_acquire);
+
+	first = mBuffer.data() + index;
+
+	return std::min(max, 
+			std::min(capacity() - (tail - mCachedHead), capacity() - index));
+}
+
+template<typename T>
+void RingQueue<T>::commit(size_t count)
+{
+	mTail.store(mTail.load(std::memory_order_relaxed) + count, 
+			std::memory_order_release);
+	mNotEmpty.notifyAll();
+}
+
+template<typename T>
+size_t RingQueue<T>::view(T const*& first)
+{
+	auto head = mHead.load(std::memory_order_relaxed);
+	auto index = head & mMask;
+
+	if (mCachedTail - head < capacity() - index)
+		mCachedTail = mTail.load(std::memory_order_acquire);
+
+	first = mBuffer.data() + index;
+
+	return std::min(mCachedTail - head, capacity() - index);
+}
+
+template<typename T>
+void RingQueue<T>::release(size_t count)
+{
+	mHead.store(mHead.load(std::memory_order_relaxed) + count,
+			std::memory_order_release);
+}
+
+} // namespace queue
+} // namespace tamgef
+
+#endif
@@ -0,0 +1,426 @@
+#ifndef SHARED_MEMORY_QUEUE_H
+#define SHARED_MEMORY_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <queue/iqueue.h>
+
+namespace tamgef {
+namespace queue {
+
+/// @brief Single-producer, single-consumer ring buffer in named POSIX
+/// shared memory, for handing elements to another process.
+/// @details One process creates the ring by name and capacity, the other
+/// attaches to it by name. Only one thread of either may enqueue and only
+/// one may dequeue at a time. Empty waits sleep on a futex in the ring.
+/// The creator unlinks the name when destroyed, an attached ring stays
+/// mapped until it's destroyed too.
+template<typename T>
+class SharedMemoryQueue : public IQueue<T>
+{
+	static_assert(std::is_trivially_copyable<T>::value,
+			"Shared memory elements must be trivially copyable");
+	static_assert(alignof(T) <= 64,
+			"Shared memory elements must fit a cache line alignment");
+
+public:
+	// creates the ring, throws std::runtime_error if the name is taken
+	SharedMemoryQueue(std::string const& name, size_t capacity);
+
+	// attaches to a ring created by another SharedMemoryQueue, throws
+	// std::runtime_error if there is none or it holds another type
+	SharedMemoryQueue(std::string const& name);
+
+	SharedMemoryQueue(SharedMemoryQueue<T> const&) = delete;
+	virtual ~SharedMemoryQueue();
+
+	bool empty() const override;
+
+	// throws std::overflow_error if the ring is full
+	void enqueue(T element) override;
+	size_t size() const override;
+
+	// throws std::overflow_error if the ring can't hold all elements
+	void enqueueBulk(T const*, size_t) override;
+	bool tryDequeue(T &) override;
+	size_t tryDequeueBulk(T*, size_t) override;
+	bool wait(std::chrono::microseconds) override;
+
+	size_t capacity() const;
+	std::string const& name() const;
+
+	// return false or a short count instead of throwing when full
+	bool tryEnqueue(T element) override;
+	size_t tryEnqueueBulk(T const*, size_t) override;
+
+private:
+	static const uint64_t sMagic = 0x74616d6765667131; // "tamgefq1"
+	static const size_t sCacheLineSize = 64;
+
+	// laid out at the start of the mapping, followed by the slots
+	struct Header
+	{
+		uint64_t magic;
+		uint64_t elementSize;
+		uint64_t capacity;
+
+		char padding0[sCacheLineSize];
+		std::atomic<uint64_t> head;
+
+		char padding1[sCacheLineSize];
+		std::atomic<uint64_t> tail;
+
+		// bumped on every wake-up, the futex word
+		char padding2[sCacheLineSize];
+		std::atomic<uint32_t> wakeUps;
+		std::atomic<uint32_t> waiters;
+	};
+
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+			"Futex words must be plain 32 bit integers");
+
+	static size_t checkCapacity(size_t);
+	static size_t mappingSize(size_t capacity);
+	static size_t slotsOffset();
+
+	std::string const mName;
+	bool const mOwner;
+	size_t mSize;
+	Header* pHeader;
+	T* pSlots;
+
+	void map(int fd, size_t size);
+	void notify();
+	void publish(uint64_t tail);
+};
+
+template<typename T>
+size_t SharedMemoryQueue<T>::checkCapacity(size_t capacity)
+{
+	if (capacity == 0)
+		throw std::invalid_argument("Empty ring capacity");
+
+	size_t powerOfTwo = 1;
+
+	while (powerOfTwo < capacity)
+		powerOfTwo <<= 1;
+
+	return powerOfTwo;
+}
+
+template<typename T>
+size_t SharedMemoryQueue<T>::mappingSize(size_t capacity)
+{
+	return slotsOffset() + capacity * sizeof(T);
+}
+
+// slots start on the cache line after the header
+template<typename T>
+size_t SharedMemoryQueue<T>::slotsOffset()
+{
+	return (sizeof(Header) + sCacheLineSize - 1) / sCacheLineSize *
+		sCacheLineSize;
+}
+
+template<typename T>
+SharedMemoryQueue<T>::SharedMemoryQueue(
+		std::string const& name,
+		size_t capacity) :
+	mName(name),
+	mOwner(true),
+	mSize(mappingSize(checkCapacity(capacity))),
+	pHeader(nullptr),
+	pSlots(nullptr)
+{
+	int fd = ::shm_open(mName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+	if (fd == -1)
+		throw std::runtime_error(
+				"Can't create shared memory " + mName + ": " +
+				std::strerror(errno));
+
+	if (::ftruncate(fd, mSize) == -1)
+	{
+		auto error = errno;
+		::close(fd);
+		::shm_unlink(mName.c_str());
+
+		throw std::runtime_error(
+				"Can't size shared memory " + mName + ": " +
+				std::strerror(error));
+	}
+
+	try
+	{
+		map(fd, mSize);
+	}
+	catch (...)
+	{
+		::shm_unlink(mName.c_str());
+		throw;
+	}
+
+	// a fresh mapping is zeroed, the magic goes in last so attaching
+	// processes never see a half written header
+	pHeader->elementSize = sizeof(T);
+	pHeader->capacity = checkCapacity(capacity);
+	pHeader->head.store(0, std::memory_order_relaxed);
+	pHeader->tail.store(0, std::memory_order_relaxed);
+	pHeader->wakeUps.store(0, std::memory_order_relaxed);
+	pHeader->waiters.store(0, std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_release);
+	pHeader->magic = sMagic;
+}
+
+template<typename T>
+SharedMemoryQueue<T>::SharedMemoryQueue(std::string const& name) :
+	mName(name),
+	mOwner(false),
+	mSize(0),
+	pHeader(nullptr),
+	pSlots(nullptr)
+{
+	int fd = ::shm_open(mName.c_str(), O_RDWR, 0600);
+
+	if (fd == -1)
+		throw std::runtime_error(
+				"Can't open shared memory " + mName + ": " +
+				std::strerror(errno));
+
+	struct stat status;
+
+	if (::fstat(fd, &status) == -1 ||
+			size_t(status.st_size) < sizeof(Header))
+	{
+		::close(fd);
+		throw std::runtime_error("Shared memory " + mName + " isn't a queue");
+	}
+
+	map(fd, status.st_size);
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	if (pHeader->magic != sMagic ||
+			pHeader->elementSize != sizeof(T) ||
+			mappingSize(pHeader->capacity) > mSize)
+	{
+		::munmap(pHeader, mSize);
+		throw std::runtime_error("Shared memory " + mName + " isn't a queue");
+	}
+}
+
+template<typename T>
+SharedMemoryQueue<T>::~SharedMemoryQueue()
+{
+	::munmap(pHeader, mSize);
+
+	if (mOwner)
+		::shm_unlink(mName.c_str());
+}
+
+template<typename T>
+bool SharedMemoryQueue<T>::empty() const
+{
+	return size() == 0;
+}
+
+template<typename T>
+void SharedMemoryQueue<T>::enqueue(T element)
+{
+	if (!tryEnqueue(element))
+		throw std::overflow_error("Ring capacity exceeded");
+}
+
+template<typename T>
+size_t SharedMemoryQueue<T>::size() const
+{
+	auto head = pHeader->head.load(std::memory_order_acquire);
+	auto tail = pHeader->tail.load(std::memory_order_acquire);
+
+	return tail - head;
+}
+
+template<typename T>
+void SharedMemoryQueue<T>::enqueueBulk(T const* elements, size_t count)
+{
+	auto tail = pHeader->tail.load(std::memory_order_relaxed);
+	auto head = pHeader->head.load(std::memory_order_acquire);
+
+	if (tail + count - head > capacity())
+		throw std::overflow_error("Ring capacity exceeded");
+
+	for (size_t i = 0; i < count; ++i)
+		pSlots[(tail + i) & (capacity() - 1)] = elements[i];
+
+	publish(tail + count);
+}
+
+template<typename T>
+bool SharedMemoryQueue<T>::tryDequeue(T & element)
+{
+	return tryDequeueBulk(&element, 1) == 1;
+}
+
+template<typename T>
+size_t SharedMemoryQueue<T>::tryDequeueBulk(T* elements, size_t max)
+{
+	auto head = pHeader->head.load(std::memory_order_relaxed);
+	auto tail = pHeader->tail.load(std::memory_order_acquire);
+	auto count = std::min<size_t>(max, tail - head);
+
+	for (size_t i = 0; i < count; ++i)
+		elements[i] = pSlots[(head + i) & (capacity() - 1)];
+
+	if (count != 0)
+		pHeader->head.store(head + count, std::memory_order_release);
+
+	return count;
+}
+
+template<typename T>
+bool SharedMemoryQueue<T>::wait(std::chrono::microseconds timeout)
+{
+	if (!empty())
+		return true;
+
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+
+	pHeader->waiters.fetch_add(1, std::memory_order_seq_cst);
+
+	while (empty())
+	{
+		auto remaining = deadline - std::chrono::steady_clock::now();
+
+		if (remaining <= std::chrono::steady_clock::duration::zero())
+			break;
+
+		// read before checking again, so a wake-up in between makes the
+		// futex return at once instead of being missed
+		auto wakeUps = pHeader->wakeUps.load(std::memory_order_seq_cst);
+
+		if (!empty())
+			break;
+
+		auto seconds =
+			std::chrono::duration_cast<std::chrono::seconds>(remaining);
+		struct timespec relative;
+		relative.tv_sec = seconds.count();
+		relative.tv_nsec =
+			std::chrono::duration_cast<std::chrono::nanoseconds>(
+					remaining - seconds).count();
+
+		::syscall(SYS_futex, &pHeader->wakeUps, FUTEX_WAIT, wakeUps,
+				&relative, nullptr, 0);
+	}
+
+	pHeader->waiters.fetch_sub(1, std::memory_order_relaxed);
+
+	return !empty();
+}
+
+template<typename T>
+size_t SharedMemoryQueue<T>::capacity() const
+{
+	return pHeader->capacity;
+}
+
+template<typename T>
+std::string const& SharedMemoryQueue<T>::name() const
+{
+	return mName;
+}
+
+template<typename T>
+bool SharedMemoryQueue<T>::tryEnqueue(T element)
+{
+	auto tail = pHeader->tail.load(std::memory_order_relaxed);
+
+	if (tail - pHeader->head.load(std::memory_order_acquire) == capacity())
+		return false;
+
+	pSlots[tail & (capacity() - 1)] = element;
+	publish(tail + 1);
+
+	return true;
+}
+
+template<typename T>
+size_t SharedMemoryQueue<T>::tryEnqueueBulk(T const* elements, size_t count)
+{
+	auto tail = pHeader->tail.load(std::memory_order_relaxed);
+	auto head = pHeader->head.load(std::memory_order_acquire);
+
+	count = std::min<size_t>(count, capacity() - (tail - head));
+
+	if (count == 0)
+		return 0;
+
+	for (size_t i = 0; i < count; ++i)
+		pSlots[(tail + i) & (capacity() - 1)] = elements[i];
+
+	publish(tail + count);
+
+	return count;
+}
+
+template<typename T>
+void SharedMemoryQueue<T>::map(int fd, size_t size)
+{
+	void* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, 0);
+	auto error = errno;
+
+	::close(fd);
+
+	if (address == MAP_FAILED)
+		throw std::runtime_error(
+				"Can't map shared memory " + mName + ": " +
+				std::strerror(error));
+
+	mSize = size;
+	pHeader = static_cast<Header*>(address);
+	pSlots = reinterpret_cast<T*>(static_cast<char*>(address) + slotsOffset());
+}
+
+// wakes waiters in any process, only costs a fence while there are none
+template<typename T>
+void SharedMemoryQueue<T>::notify()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (pHeader->waiters.load(std::memory_order_relaxed) == 0)
+		return;
+
+	pHeader->wakeUps.fetch_add(1, std::memory_order_seq_cst);
+	::syscall(SYS_futex, &pHeader->wakeUps, FUTEX_WAKE, INT_MAX,
+			nullptr, nullptr, 0);
+}
+
+template<typename T>
+void SharedMemoryQueue<T>::publish(uint64_t tail)
+{
+	pHeader->tail.store(tail, std::memory_order_release);
+	notify();
+}
+
+} // namespace queue
+} // namespace tamgef
+
+#endif
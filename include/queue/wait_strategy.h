@@ -0,0 +1,137 @@
+#ifndef WAIT_STRATEGY_H
+#define WAIT_STRATEGY_H
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace tamgef {
+namespace queue {
+
+/// @brief Hints the processor that the caller is spinning.
+inline void cpuRelax()
+{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	_mm_pause();
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	__builtin_ia32_pause();
+#endif
+}
+
+/// @brief How a poller waits while its queue is empty.
+/// @details Strategies hold no per-poller state, so one instance can be
+/// shared between pollers.
+class WaitStrategy
+{
+public:
+	/// @brief Blocks on the queue for up to a timeout, returns @p true
+	/// if the queue became non-empty.
+	typedef std::function<bool(std::chrono::microseconds)> Park;
+
+	virtual ~WaitStrategy() = default;
+
+	/// @brief Called each time the poller finds its queue empty.
+	/// @param idle Number of consecutive empty polls before this one.
+	/// @param park Blocks on the polled queue.
+	virtual void idle(size_t idle, Park const& park) const = 0;
+};
+
+/// @brief Polls again immediately, lowest latency at a full core.
+class BusySpinWait : public WaitStrategy
+{
+public:
+	void idle(size_t, Park const&) const override
+	{
+		cpuRelax();
+	}
+};
+
+/// @brief Yields the rest of the time slice between polls.
+class YieldWait : public WaitStrategy
+{
+public:
+	void idle(size_t, Park const&) const override
+	{
+		std::this_thread::yield();
+	}
+};
+
+/// @brief Sleeps between polls, doubling the sleep up to a maximum.
+class BackoffWait : public WaitStrategy
+{
+public:
+	BackoffWait(
+			std::chrono::microseconds minimum = std::chrono::microseconds(1),
+			std::chrono::microseconds maximum = std::chrono::microseconds(1000)) :
+		mMinimum(minimum),
+		mMaximum(maximum)
+	{}
+
+	void idle(size_t idle, Park const&) const override
+	{
+		auto doublings = std::min<size_t>(idle, 20);
+		std::this_thread::sleep_for(
+				std::min(mMaximum, mMinimum * (1 << doublings)));
+	}
+
+private:
+	std::chrono::microseconds mMinimum;
+	std::chrono::microseconds mMaximum;
+};
+
+/// @brief Blocks on the queue until it's written to.
+/// @details The timeout bounds how long stopping an idle poller takes.
+class ParkWait : public WaitStrategy
+{
+public:
+	ParkWait(std::chrono::microseconds timeout = std::chrono::milliseconds(1)) :
+		mTimeout(timeout)
+	{}
+
+	void idle(size_t, Park const& park) const override
+	{
+		park(mTimeout);
+	}
+
+private:
+	std::chrono::microseconds mTimeout;
+};
+
+/// @brief Spins, then yields, then parks as the queue stays empty.
+class AdaptiveWait : public WaitStrategy
+{
+public:
+	AdaptiveWait(
+			size_t spins = 100,
+			size_t yields = 10,
+			std::chrono::microseconds timeout = std::chrono::milliseconds(1)) :
+		mSpins(spins),
+		mYields(yields),
+		mTimeout(timeout)
+	{}
+
+	void idle(size_t idle, Park const& park) const override
+	{
+		if (idle < mSpins)
+			cpuRelax();
+		else if (idle < mSpins + mYields)
+			std::this_thread::yield();
+		else
+			park(mTimeout);
+	}
+
+private:
+	size_t mSpins;
+	size_t mYields;
+	std::chrono::microseconds mTimeout;
+};
+
+} // namespace queue
+} // namespace tamgef
+
+#endif
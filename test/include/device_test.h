@@ -5,9 +5,13 @@
 
 #include <device/device.h>
 #include <device/event.h>
+#include <device/static_device.h>
 #include <gtest/gtest.h>
+#include <queue/broadcast_queue.h>
+#include <queue/conflating_queue.h>
 #include <queue/queue_reader.h>
 #include <queue/queue.h>
+#include <queue/ring_queue.h>
 
 #include "circuit.h"
 
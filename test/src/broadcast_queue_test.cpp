@@ -0,0 +1,247 @@
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <queue/broadcast_queue.h>
+#include <queue/queue_poller.h>
+#include <queue/queue_reader.h>
+
+TEST(BroadcastQueueTest, constructor)
+{
+	EXPECT_THROW(tamgef::queue::BroadcastQueue<int>(0), std::invalid_argument);
+	EXPECT_EQ(tamgef::queue::BroadcastQueue<int>(5).capacity(), 8);
+}
+
+TEST(BroadcastQueueTest, broadcast)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::BroadcastQueue<int>>(8);
+	std::vector<int> sent({ 1, 2, 3 });
+	int recieved(0);
+
+	// each reader subscribes a cursor of its own
+	tamgef::queue::QueueReader<int> first_reader(queue_ptr);
+	tamgef::queue::QueueReader<int> second_reader;
+	second_reader.connect(queue_ptr);
+
+	queue_ptr->enqueueBulk(sent.data(), sent.size());
+	queue_ptr->enqueue(4);
+
+	for (auto reader : { &first_reader, &second_reader })
+	{
+		EXPECT_EQ(reader->size(), 4);
+
+		for (int expected = 1; expected <= 4; ++expected)
+		{
+			ASSERT_TRUE(reader->tryDequeue(recieved));
+			EXPECT_EQ(recieved, expected);
+		}
+
+		EXPECT_FALSE(reader->tryDequeue(recieved));
+	}
+
+	// the queue itself can't be read
+	EXPECT_THROW(queue_ptr->tryDequeue(recieved), std::logic_error);
+
+	// unsubscribed readers expire
+	auto cursor_ptr = queue_ptr->cursor();
+	tamgef::queue::QueueReader<int> cursor_reader(cursor_ptr);
+	queue_ptr->unsubscribe(cursor_ptr);
+	cursor_ptr.reset();
+	EXPECT_TRUE(cursor_reader.expired());
+}
+
+TEST(BroadcastQueueTest, reader_destroyed)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::BroadcastQueue<int>>(4);
+	tamgef::queue::QueueReader<int> kept_reader(queue_ptr);
+
+	{
+		tamgef::queue::QueueReader<int> dropped_reader(queue_ptr);
+		tamgef::queue::QueueReader<int> copied_reader(dropped_reader);
+		EXPECT_EQ(queue_ptr->readers(), 2);
+	}
+
+	// the dropped reader's cursor no longer gates the producer
+	EXPECT_EQ(queue_ptr->readers(), 1);
+	kept_reader.disconnect();
+	EXPECT_EQ(queue_ptr->readers(), 0);
+
+	for (int i = 0; i < 8; ++i)
+		queue_ptr->enqueue(i);
+
+	EXPECT_TRUE(queue_ptr->empty());
+}
+
+TEST(BroadcastQueueTest, gating)
+{
+	const int sent(1 << 12);
+	auto queue_ptr = std::make_shared<tamgef::queue::BroadcastQueue<int>>(4);
+	auto cursor_ptr = queue_ptr->cursor();
+
+	// the producer outruns the ring and has to wait for the reader
+	std::thread producer([&]
+			{
+				for (int i = 0; i < sent; ++i)
+					queue_ptr->enqueue(i);
+			});
+
+	int expected(0), recieved(0);
+
+	while (expected < sent)
+	{
+		ASSERT_LE(cursor_ptr->size(), queue_ptr->capacity());
+
+		if (!cursor_ptr->tryDequeue(recieved))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		ASSERT_EQ(recieved, expected);
+		++expected;
+	}
+
+	producer.join();
+	EXPECT_EQ(cursor_ptr->drops(), 0);
+}
+
+TEST(BroadcastQueueTest, lapping)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::BroadcastQueue<int>>(4);
+	auto cursor_ptr = queue_ptr->cursor(true);
+	std::vector<int> recieved(8);
+	const int* first(nullptr);
+
+	EXPECT_TRUE(cursor_ptr->lapping());
+	EXPECT_THROW(cursor_ptr->view(first), std::logic_error);
+
+	// never blocks, the reader skips what was overwritten
+	for (int i = 0; i < 10; ++i)
+		queue_ptr->enqueue(i);
+
+	ASSERT_EQ(cursor_ptr->tryDequeueBulk(recieved.data(), recieved.size()), 4);
+	EXPECT_EQ(recieved[0], 6);
+	EXPECT_EQ(recieved[3], 9);
+	EXPECT_EQ(cursor_ptr->drops(), 6);
+}
+
+TEST(BroadcastQueueTest, view)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::BroadcastQueue<int>>(4);
+	auto first_cursor_ptr = queue_ptr->cursor();
+	auto second_cursor_ptr = queue_ptr->cursor();
+	std::vector<int> sent({ 1, 2, 3 });
+	const int* first(nullptr);
+	const int* second(nullptr);
+
+	queue_ptr->enqueueBulk(sent.data(), sent.size());
+
+	// both readers see the same elements in place
+	ASSERT_EQ(first_cursor_ptr->view(first), 3);
+	ASSERT_EQ(second_cursor_ptr->view(second), 3);
+	EXPECT_EQ(first, second);
+	EXPECT_EQ(first[2], 3);
+
+	first_cursor_ptr->release(3);
+	EXPECT_TRUE(first_cursor_ptr->empty());
+	EXPECT_EQ(queue_ptr->size(), 3);
+
+	second_cursor_ptr->release(2);
+	EXPECT_EQ(queue_ptr->size(), 1);
+
+	// views stop at the end of the ring
+	queue_ptr->enqueueBulk(sent.data(), sent.size());
+	EXPECT_EQ(second_cursor_ptr->view(second), 2);
+	EXPECT_EQ(second[0], 3);
+	EXPECT_EQ(second[1], 1);
+
+	// readers view through their consumer sessions, on a ring of their
+	// own since the cursors above still gate this one
+	auto reader_queue_ptr = std::make_shared<tamgef::queue::BroadcastQueue<int>>(4);
+	tamgef::queue::QueueReader<int> queue_reader(reader_queue_ptr);
+	auto consumer = queue_reader.consumer();
+	reader_queue_ptr->enqueue(4);
+
+	ASSERT_EQ(consumer.view(first), 1);
+	EXPECT_EQ(*first, 4);
+	consumer.release(1);
+	EXPECT_TRUE(queue_reader.empty());
+}
+
+TEST(BroadcastQueueTest, gate_limit)
+{
+	typedef tamgef::queue::BroadcastQueue<int> broadcast_queue;
+
+	auto queue_ptr = std::make_shared<broadcast_queue>(4);
+	std::vector<std::shared_ptr<broadcast_queue::Cursor>> cursors;
+
+	for (size_t i = 0; i < broadcast_queue::sMaxGates; ++i)
+		cursors.push_back(queue_ptr->cursor());
+
+	EXPECT_THROW(queue_ptr->cursor(), std::length_error);
+	EXPECT_EQ(queue_ptr->readers(), broadcast_queue::sMaxGates);
+
+	// lapping cursors take no gate
+	EXPECT_NO_THROW(queue_ptr->cursor(true));
+
+	// a destroyed cursor's gate is taken again
+	queue_ptr->unsubscribe(cursors.back());
+	cursors.pop_back();
+	cursors.push_back(queue_ptr->cursor());
+
+	queue_ptr->enqueue(1);
+
+	for (auto const& cursor_ptr : cursors)
+		EXPECT_EQ(cursor_ptr->size(), 1);
+}
+
+// has no default constructor, so is dequeued in place
+struct broadcast_sample
+{
+	explicit broadcast_sample(int value) : value(value) {}
+	int value;
+};
+
+TEST(BroadcastQueueTest, no_default_constructor)
+{
+	auto timeout(std::chrono::milliseconds(10));
+	auto queue_ptr = std::make_shared<
+			tamgef::queue::BroadcastQueue<broadcast_sample>>(4);
+	std::atomic<int> batched(0);
+
+	{
+		tamgef::queue::QueuePoller<broadcast_sample> batch_poller(
+				tamgef::queue::QueueReader<broadcast_sample>(queue_ptr),
+				[&batched](broadcast_sample const* first, size_t count)
+				{
+					for (size_t i = 0; i < count; ++i)
+						batched.fetch_add(first[i].value);
+				},
+				2);
+
+		// laps the ring, so slots are both constructed and assigned
+		for (int i = 1; i <= 6; ++i)
+			queue_ptr->enqueue(broadcast_sample(i));
+
+		// I know, I know
+		std::this_thread::sleep_for(timeout);
+		EXPECT_TRUE(batch_poller.polling());
+	}
+
+	EXPECT_EQ(batched.load(), 1 + 2 + 3 + 4 + 5 + 6);
+
+	auto cursor_ptr = queue_ptr->cursor();
+	auto lapping_ptr = queue_ptr->cursor(true);
+	std::vector<char> storage(2 * sizeof(broadcast_sample));
+	auto elements = reinterpret_cast<broadcast_sample*>(storage.data());
+
+	queue_ptr->enqueue(broadcast_sample(7));
+
+	ASSERT_EQ(cursor_ptr->tryDequeueBulkInto(elements, 2), 1);
+	EXPECT_EQ(elements[0].value, 7);
+	ASSERT_EQ(lapping_ptr->tryDequeueBulkInto(elements + 1, 1), 1);
+	EXPECT_EQ(elements[1].value, 7);
+}
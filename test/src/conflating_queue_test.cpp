@@ -0,0 +1,103 @@
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <queue/conflating_queue.h>
+#include <queue/queue_reader.h>
+
+// position of one touch contact
+struct contact
+{
+	size_t id;
+	float x;
+};
+
+TEST(ConflatingQueueTest, constructor)
+{
+	EXPECT_THROW(tamgef::queue::ConflatingQueue<int>(0, 
+				[](int const&) -> size_t { return 0; }), 
+			std::invalid_argument);
+	EXPECT_THROW(tamgef::queue::ConflatingQueue<int>(1, nullptr), 
+			std::invalid_argument);
+	EXPECT_EQ(tamgef::queue::ConflatingQueue<int>().keys(), 1);
+}
+
+TEST(ConflatingQueueTest, latest)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::ConflatingQueue<int>>();
+	tamgef::queue::QueueReader<int> queue_reader(queue_ptr);
+	std::vector<int> sent({ 2, 3, 4 });
+	int recieved(0);
+
+	queue_ptr->enqueue(1);
+	queue_ptr->enqueueBulk(sent.data(), sent.size());
+
+	EXPECT_EQ(queue_reader.size(), 1);
+	EXPECT_EQ(queue_reader.drops(), 3);
+	EXPECT_TRUE(queue_reader.tryDequeue(recieved));
+	EXPECT_EQ(recieved, 4);
+	EXPECT_FALSE(queue_reader.tryDequeue(recieved));
+
+	queue_ptr->enqueue(5);
+	EXPECT_TRUE(queue_reader.wait(std::chrono::microseconds::zero()));
+	EXPECT_EQ(queue_reader.dequeue(), 5);
+	EXPECT_EQ(queue_reader.drops(), 3);
+}
+
+TEST(ConflatingQueueTest, keys)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::ConflatingQueue<contact>>(
+			10, [](contact const& touch) { return touch.id; });
+	tamgef::queue::QueueReader<contact> queue_reader(queue_ptr);
+	std::vector<contact> recieved(10);
+
+	queue_ptr->enqueue({ 3, 0.1f });
+	queue_ptr->enqueue({ 1, 0.2f });
+	queue_ptr->enqueue({ 3, 0.3f });
+	queue_ptr->enqueue({ 7, 0.4f });
+
+	EXPECT_THROW(queue_ptr->enqueue({ 10, 0.5f }), std::out_of_range);
+
+	// one element per key, in the order keys were first updated
+	ASSERT_EQ(queue_reader.tryDequeueBulk(recieved.data(), recieved.size()), 3);
+	EXPECT_EQ(recieved[0].id, 3);
+	EXPECT_EQ(recieved[0].x, 0.3f);
+	EXPECT_EQ(recieved[1].id, 1);
+	EXPECT_EQ(recieved[2].id, 7);
+	EXPECT_EQ(queue_reader.drops(), 1);
+	EXPECT_TRUE(queue_reader.empty());
+}
+
+TEST(ConflatingQueueTest, producer_consumer)
+{
+	const int sent(1 << 16);
+	auto queue_ptr = std::make_shared<tamgef::queue::ConflatingQueue<int>>();
+	tamgef::queue::QueueReader<int> queue_reader(queue_ptr);
+
+	std::thread producer([&]
+			{
+				for (int i = 0; i < sent; ++i)
+					queue_ptr->enqueue(i);
+			});
+
+	int last(-1), recieved(0), count(0);
+
+	while (last != sent - 1)
+	{
+		if (!queue_reader.tryDequeue(recieved))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// values only move forward
+		ASSERT_GT(recieved, last);
+		last = recieved;
+		++count;
+	}
+
+	producer.join();
+	EXPECT_EQ(queue_reader.drops() + count, sent);
+}
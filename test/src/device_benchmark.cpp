@@ -1,8 +1,15 @@
 #include "device_benchmark.h"
 
+#include <vector>
+
 #include <benchmark/benchmark.h>
 #include <device/device.h>
+#include <device/static_device.h>
+#include <queue/queue_reader.h>
+
+using namespace tamgef::queue;
 
+// no readers are attached, so this measures the stage calls only
 static void device_read_input(benchmark::State & state)
 {
 	circuit_initialize();
@@ -10,7 +17,52 @@ static void device_read_input(benchmark::State & state)
 	{
 		circuit_device_ptr->read(circuit::volts(state.range_x()));
 	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+static void static_device_read_input(benchmark::State & state)
+{
+	circuit_initialize();
+	while (state.KeepRunning())
+	{
+		static_circuit_device_ptr->read(circuit::volts(state.range_x()));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+// out of the input domain, switched on and broken
+BENCHMARK(device_read_input)->Arg(-1)->Arg(5)->Arg(200);
+BENCHMARK(static_device_read_input)->Arg(-1)->Arg(5)->Arg(200);
+
+// one packet of inputs per iteration, with an output and an event reader
+// attached and drained in bulk; Arg(0) reads the packet one by one
+static void device_read_packet(benchmark::State & state)
+{
+	const size_t packet_size = 64;
+	circuit_initialize();
+
+	std::vector<circuit::volts> voltages(packet_size, circuit::volts(5));
+	std::vector<circuit::amps> currents(packet_size);
+	std::vector<circuit_device_event> events(2 * packet_size);
+	QueueReader<circuit::amps> current_reader;
+	QueueReader<circuit_device_event> event_reader;
+
+	circuit_device_ptr->connect(current_reader);
+	circuit_device_ptr->connect(event_reader);
+
+	while (state.KeepRunning())
+	{
+		if (state.range_x() != 0)
+			circuit_device_ptr->read(voltages.data(), voltages.size());
+		else
+			for (auto const& voltage : voltages)
+				circuit_device_ptr->read(voltage);
+
+		current_reader.tryDequeueBulk(currents.data(), currents.size());
+		event_reader.tryDequeueBulk(events.data(), events.size());
+	}
+
+	state.SetItemsProcessed(state.iterations() * packet_size);
 }
 
-BENCHMARK(device_read_input)->Range(-1 << 10, 1 >> 10);
-BENCHMARK_MAIN();
+BENCHMARK(device_read_packet)->Arg(0)->Arg(1);
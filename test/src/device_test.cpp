@@ -1,12 +1,18 @@
 #include "device_test.h"
 
 #include <exception>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 #include <queue/queue_reader.h>
+#include <queue/shared_memory_queue.h>
 
 TEST_F(DeviceTest, constuctor)
 {	
@@ -63,3 +69,690 @@ TEST_F(DeviceTest, read_input)
 			std::bad_function_call);
 }
 
+TEST_F(DeviceTest, read_unsubscribed)
+{
+	// nobody reads, only the state updates
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	EXPECT_TRUE(circuit_device_ptr->state().is_on);
+
+	// delivery resumes as soon as readers connect
+	circuit_device_ptr->connect(*current_queue_reader_ptr);
+	circuit_device_ptr->connect(*event_queue_reader_ptr);
+	EXPECT_TRUE(current_queue_reader_ptr->empty());
+	EXPECT_TRUE(event_queue_reader_ptr->empty());
+
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	EXPECT_EQ(current_queue_reader_ptr->size(), 1);
+	EXPECT_EQ(event_queue_reader_ptr->size(), 2);
+
+	current_queue_reader_ptr->disconnect();
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(1)));
+	EXPECT_FALSE(circuit_device_ptr->state().is_on);
+	EXPECT_EQ(event_queue_reader_ptr->size(), 4);
+}
+
+TEST_F(DeviceTest, connect_link)
+{
+	typedef tamgef::device::GenericDevice
+		<
+			circuit::volts,
+			circuit::volts,
+			circuit::state,
+			circuit::events
+		> source_device;
+
+	source_device voltage_source(
+			[](circuit::volts) { return true; },
+			[](circuit::volts) { return true; },
+			[](circuit::volts voltage) { return voltage; },
+			[](circuit::state state, circuit::volts, circuit::volts) 
+			{ 
+				return state; 
+			},
+			{});
+
+	auto link_ptr = std::make_shared<RingQueue<circuit::volts>>(4);
+	ASSERT_NO_THROW(circuit_device_ptr->connect(voltage_source, link_ptr));
+
+	EXPECT_TRUE(voltage_source.read(circuit::volts(5)));
+	EXPECT_EQ(link_ptr->size(), 1);
+
+	EXPECT_TRUE(circuit_device_ptr->read());
+	EXPECT_TRUE(circuit_device_ptr->state().is_on);
+	EXPECT_FALSE(circuit_device_ptr->read());
+
+	EXPECT_THROW(circuit_device_ptr->setOutputQueue(nullptr), 
+			std::invalid_argument);
+}
+
+TEST_F(DeviceTest, set_output_queue)
+{
+	// read by another process, no QueueReader here counts it
+	auto name = "/tamgef_test_" + std::to_string(::getpid()) + "_device";
+	auto shared_ptr =
+		std::make_shared<SharedMemoryQueue<circuit::amps>>(name, 4);
+	SharedMemoryQueue<circuit::amps> consumer(name);
+	circuit::amps current;
+
+	circuit_device_ptr->setOutputQueue(shared_ptr);
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	ASSERT_TRUE(consumer.tryDequeue(current));
+	EXPECT_EQ(current.value, 0.05);
+
+	// dequeued directly, in bulk as well
+	auto queue_ptr = std::make_shared<Queue<circuit::amps>>();
+	const circuit::volts voltages[] = { circuit::volts(1), circuit::volts(5) };
+
+	circuit_device_ptr->setOutputQueue(queue_ptr);
+	EXPECT_EQ(circuit_device_ptr->read(voltages, 2), 2);
+	EXPECT_EQ(queue_ptr->size(), 2);
+
+	auto device = tamgef::device::makeStaticDevice<
+		circuit::volts,
+		circuit::amps,
+		circuit::state,
+		circuit::events>(
+			[](circuit::volts) { return true; },
+			[](circuit::amps) { return true; },
+			[](circuit::volts voltage) { return circuit::amps(voltage.value / 100); },
+			[](circuit::state state, circuit::volts, circuit::amps)
+			{
+				return state;
+			});
+
+	device.setOutputQueue(queue_ptr);
+	EXPECT_TRUE(device.read(circuit::volts(3)));
+	EXPECT_EQ(queue_ptr->size(), 3);
+}
+
+TEST_F(DeviceTest, connect_ring_full)
+{
+	std::vector<circuit::volts> voltages{ 5, 1, 5, 1 };
+
+	circuit_device_ptr->setOutputQueue(
+			std::make_shared<RingQueue<circuit::amps>>(2));
+	circuit_device_ptr->connect(*current_queue_reader_ptr);
+	circuit_device_ptr->connect(*event_queue_reader_ptr);
+
+	// the full ring drops outputs, events and the state carry on
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	EXPECT_NO_THROW(circuit_device_ptr->read(circuit::volts(1)));
+	EXPECT_FALSE(circuit_device_ptr->state().is_on);
+	EXPECT_EQ(circuit_device_ptr->drops(), 1);
+	EXPECT_EQ(current_queue_reader_ptr->size(), 2);
+	EXPECT_EQ(event_queue_reader_ptr->size(), 6);
+
+	// batches keep what fits
+	current_queue_reader_ptr->dequeue();
+	EXPECT_EQ(circuit_device_ptr->read(voltages.data(), voltages.size()), 4);
+	EXPECT_FALSE(circuit_device_ptr->state().is_on);
+	EXPECT_EQ(circuit_device_ptr->drops(), 1 + 3);
+	EXPECT_EQ(current_queue_reader_ptr->size(), 2);
+	EXPECT_EQ(event_queue_reader_ptr->size(), 6 + 8);
+}
+
+// counts every copy and move
+struct device_frame
+{
+	static size_t transfers;
+
+	device_frame() : value(0) {}
+	device_frame(device_frame const& other) : value(other.value) { ++transfers; }
+
+	device_frame & operator=(device_frame const& other)
+	{
+		value = other.value;
+		++transfers;
+
+		return *this;
+	}
+
+	double value;
+};
+
+size_t device_frame::transfers = 0;
+
+TEST_F(DeviceTest, connect_loan)
+{
+	typedef tamgef::device::GenericDevice
+		<
+			circuit::volts,
+			device_frame,
+			circuit::state,
+			circuit::events
+		> framing_device;
+
+	auto resolve = [](circuit::volts voltage, device_frame & frame)
+	{
+		frame.value = voltage.value;
+	};
+
+	framing_device framer(
+			[](circuit::volts) { return true; },
+			[](device_frame const& frame) { return frame.value >= 0; },
+			resolve,
+			[](circuit::state state, circuit::volts, device_frame const&)
+			{
+				return state;
+			},
+			{});
+
+	auto static_framer = tamgef::device::makeStaticDevice<
+		circuit::volts,
+		device_frame,
+		circuit::state,
+		circuit::events>(
+			[](circuit::volts) { return true; },
+			[](device_frame const& frame) { return frame.value >= 0; },
+			resolve,
+			[](circuit::state state, circuit::volts, device_frame const&)
+			{
+				return state;
+			});
+
+	auto ring_ptr = std::make_shared<RingQueue<device_frame>>(4);
+	auto static_ring_ptr = std::make_shared<RingQueue<device_frame>>(4);
+	QueueReader<device_frame> frame_reader;
+	QueueReader<device_frame> static_frame_reader;
+	device_frame const* first(nullptr);
+
+	framer.setOutputQueue(ring_ptr);
+	framer.connect(frame_reader);
+	static_framer.setOutputQueue(static_ring_ptr);
+	static_framer.connect(static_frame_reader);
+
+	auto consumer = frame_reader.consumer();
+	auto static_consumer = static_frame_reader.consumer();
+	device_frame::transfers = 0;
+
+	// resolved into the slot, an output out of domain is never published
+	for (auto & device_read : std::vector<std::function<bool(circuit::volts)>>
+			{
+				[&framer](circuit::volts voltage) { return framer.read(voltage); },
+				[&static_framer](circuit::volts voltage) { return static_framer.read(voltage); }
+			})
+	{
+		EXPECT_TRUE(device_read(circuit::volts(5)));
+		EXPECT_TRUE(device_read(circuit::volts(-1)));
+		EXPECT_TRUE(device_read(circuit::volts(7)));
+	}
+
+	for (auto session : { &consumer, &static_consumer })
+	{
+		ASSERT_EQ(session->view(first), 2);
+		EXPECT_EQ(first[0].value, 5);
+		EXPECT_EQ(first[1].value, 7);
+		session->release(2);
+		EXPECT_EQ(session->view(first), 0);
+	}
+
+	EXPECT_EQ(device_frame::transfers, 0);
+
+	// queues that don't lend can't be viewed
+	circuit_device_ptr->connect(*current_queue_reader_ptr);
+	circuit::amps const* current(nullptr);
+	EXPECT_THROW(current_queue_reader_ptr->consumer().view(current),
+			std::logic_error);
+}
+
+TEST_F(DeviceTest, connect_broadcast)
+{
+	QueueReader<circuit::amps> first_reader;
+	QueueReader<circuit::amps> second_reader;
+	circuit::amps current;
+
+	circuit_device_ptr->setOutputQueue(
+			std::make_shared<BroadcastQueue<circuit::amps>>(8));
+	circuit_device_ptr->connect(first_reader);
+	circuit_device_ptr->connect(second_reader);
+
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+
+	// every reader sees every output
+	EXPECT_TRUE(first_reader.tryDequeue(current));
+	EXPECT_TRUE(second_reader.tryDequeue(current));
+	EXPECT_FALSE(first_reader.tryDequeue(current));
+}
+
+TEST_F(DeviceTest, connect_conflating)
+{
+	QueueReader<circuit::amps> current_reader;
+	circuit::amps current;
+
+	circuit_device_ptr->setOutputQueue(
+			std::make_shared<ConflatingQueue<circuit::amps>>());
+	circuit_device_ptr->connect(current_reader);
+
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(2)));
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(4)));
+
+	// only the newest output is kept
+	EXPECT_EQ(current_reader.size(), 1);
+	EXPECT_EQ(current_reader.drops(), 1);
+	EXPECT_TRUE(current_reader.tryDequeue(current));
+	EXPECT_FALSE(current_reader.tryDequeue(current));
+}
+
+TEST_F(DeviceTest, connect_record)
+{
+	QueueReader<circuit_device::DeviceRecord> record_reader;
+	std::vector<circuit_device::DeviceRecord> records(8);
+
+	circuit_device_ptr->connect(*current_queue_reader_ptr);
+	circuit_device_ptr->connect(*event_queue_reader_ptr);
+	circuit_device_ptr->connect(record_reader);
+
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(1)));
+
+	// plain readers still get theirs
+	EXPECT_EQ(current_queue_reader_ptr->size(), 2);
+	EXPECT_EQ(event_queue_reader_ptr->size(), 4);
+
+	// the output, then the events of each input
+	ASSERT_EQ(record_reader.tryDequeueBulk(records.data(), records.size()), 6);
+	EXPECT_EQ(records[0].kind(), circuit_device::DeviceRecord::Kind::Output);
+	EXPECT_EQ(records[0].input(), 0);
+	EXPECT_THROW(records[0].event(), std::logic_error);
+	EXPECT_EQ(records[2].kind(), circuit_device::DeviceRecord::Kind::Event);
+	EXPECT_EQ(records[2].event().type(), circuit::events::on);
+	EXPECT_EQ(records[3].input(), 1);
+	EXPECT_EQ(records[5].event().type(), circuit::events::off);
+
+	// in one bulk read as well
+	const circuit::volts voltages[] = { circuit::volts(5), circuit::volts(1) };
+	EXPECT_EQ(circuit_device_ptr->read(voltages, 2), 2);
+	EXPECT_EQ(current_queue_reader_ptr->size(), 4);
+	EXPECT_EQ(event_queue_reader_ptr->size(), 8);
+	EXPECT_EQ(record_reader.tryDequeueBulk(records.data(), records.size()), 6);
+
+	// switching back
+	circuit_device_ptr->setRecordQueue(nullptr);
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	EXPECT_EQ(current_queue_reader_ptr->size(), 5);
+	EXPECT_TRUE(record_reader.expired());
+}
+
+
+TEST_F(DeviceTest, static_device)
+{
+	auto device = tamgef::device::makeStaticDevice<
+		circuit::volts,
+		circuit::amps,
+		circuit::state,
+		circuit::events>(
+			[](circuit::volts voltage) { return voltage.value >= 0; },
+			[](circuit::amps current) { return current.value <= 2; },
+			[](circuit::volts voltage) { return circuit::amps(voltage.value / 100); },
+			[](circuit::state, circuit::volts voltage, circuit::amps)
+			{
+				return circuit::state(voltage.value >= 2);
+			},
+			[](circuit::state current_state) -> circuit_device_event
+			{
+				if (current_state.is_on)
+					return circuit_device_event(circuit::events::on);
+
+				return circuit_device_event(circuit::events::off);
+			},
+			[](circuit::state) { return circuit::events::none; });
+
+	EXPECT_THROW(device.read(), std::runtime_error);
+	EXPECT_FALSE(device.read(circuit::volts(-1)));
+
+	device.connect(*current_queue_reader_ptr);
+	device.connect(*event_queue_reader_ptr);
+
+	EXPECT_TRUE(device.read(circuit::volts(5)));
+	EXPECT_TRUE(device.state().is_on);
+	EXPECT_EQ(current_queue_reader_ptr->dequeue().value, 0.05);
+	EXPECT_EQ(event_queue_reader_ptr->dequeue().type(), circuit::events::on);
+	EXPECT_EQ(event_queue_reader_ptr->dequeue().type(), circuit::events::none);
+
+	// reads the outputs of a generic device
+	QueueReader<circuit::volts> voltage_reader;
+	auto follower = tamgef::device::makeStaticDevice<
+		circuit::amps,
+		circuit::volts,
+		circuit::state,
+		circuit::events>(
+			[](circuit::amps) { return true; },
+			[](circuit::volts) { return true; },
+			[](circuit::amps current) { return circuit::volts(current.value * 100); },
+			[](circuit::state current_state, circuit::amps, circuit::volts)
+			{
+				return current_state;
+			});
+
+	follower.connect(*circuit_device_ptr);
+	follower.connect(voltage_reader);
+	circuit_device_ptr->read(circuit::volts(100));
+
+	EXPECT_TRUE(follower.read());
+	EXPECT_EQ(voltage_reader.dequeue().value, 100);
+	EXPECT_FALSE(follower.read());
+}
+
+TEST_F(DeviceTest, read_batch)
+{
+	std::vector<circuit::volts> voltages{5, -1, 5, 1};
+	std::vector<circuit::amps> currents(8);
+	std::vector<circuit_device_event> events(8);
+
+	// nobody reads, only the state updates
+	EXPECT_EQ(circuit_device_ptr->read(voltages.data(), voltages.size()), 3);
+	EXPECT_FALSE(circuit_device_ptr->state().is_on);
+
+	circuit_device_ptr->connect(*current_queue_reader_ptr);
+	circuit_device_ptr->connect(*event_queue_reader_ptr);
+
+	// inputs out of domain are skipped
+	EXPECT_EQ(circuit_device_ptr->read(voltages.data(), voltages.size()), 3);
+	EXPECT_EQ(current_queue_reader_ptr->tryDequeueBulk(currents.data(), currents.size()), 3);
+	EXPECT_EQ(currents[2].value, 0.01);
+
+	ASSERT_EQ(event_queue_reader_ptr->tryDequeueBulk(events.data(), events.size()), 6);
+	EXPECT_EQ(events[1].type(), circuit::events::on);
+	EXPECT_EQ(events[5].type(), circuit::events::off);
+
+	// pumps from the connected queue
+	EXPECT_THROW(circuit_device_ptr->pump(4), std::runtime_error);
+	circuit_device_ptr->connect(QueueReader<circuit::volts>(voltage_queue_ptr));
+
+	voltage_queue_ptr->enqueueBulk(voltages.data(), voltages.size());
+	EXPECT_EQ(circuit_device_ptr->pump(2), 2);
+	EXPECT_TRUE(circuit_device_ptr->state().is_on);
+	EXPECT_EQ(circuit_device_ptr->pump(8), 2);
+	EXPECT_FALSE(circuit_device_ptr->state().is_on);
+	EXPECT_EQ(circuit_device_ptr->pump(8), 0);
+	EXPECT_EQ(current_queue_reader_ptr->size(), 3);
+}
+
+TEST_F(DeviceTest, envelope)
+{
+	typedef tamgef::device::GenericDevice
+		<
+			double,
+			circuit::volts,
+			circuit::state,
+			circuit::events
+		> sensor_device;
+
+	sensor_device sensor(
+			[](double) { return true; },
+			[](circuit::volts) { return true; },
+			[](double sample) { return circuit::volts(sample); },
+			[](circuit::state state, double, circuit::volts)
+			{
+				return state;
+			},
+			{});
+
+	QueueReader<tamgef::device::Envelope<circuit::volts>> voltage_reader;
+	QueueReader<circuit_device::OutputEnvelope> current_reader;
+	QueueReader<circuit_device::EventEnvelope> event_reader;
+
+	// the sensor stamps its samples, the circuit carries the stamps on
+	sensor.setDeviceId(7);
+	sensor.connect(voltage_reader);
+	circuit_device_ptr->setDeviceId(9);
+	circuit_device_ptr->connect(voltage_reader);
+	circuit_device_ptr->connect(current_reader);
+	circuit_device_ptr->connect(event_reader);
+
+	auto before = tamgef::device::monotonicTime();
+	EXPECT_TRUE(sensor.read(1));
+	EXPECT_TRUE(sensor.read(5));
+
+	EXPECT_TRUE(circuit_device_ptr->read());
+	EXPECT_EQ(circuit_device_ptr->pump(4), 1);
+	EXPECT_TRUE(circuit_device_ptr->state().is_on);
+
+	auto first = current_reader.dequeue();
+	auto second = current_reader.dequeue();
+
+	EXPECT_EQ(first.stamp.device, 7);
+	EXPECT_EQ(first.stamp.sequence, 0);
+	EXPECT_EQ(second.stamp.sequence, 1);
+	EXPECT_EQ(second.value.value, 0.05);
+	EXPECT_GE(first.stamp.timestamp, before);
+	EXPECT_LE(first.stamp.timestamp, second.stamp.timestamp);
+	EXPECT_LE(second.stamp.timestamp, tamgef::device::monotonicTime());
+
+	ASSERT_EQ(event_reader.size(), 4);
+	event_reader.dequeue();
+	event_reader.dequeue();
+	event_reader.dequeue();
+
+	auto event = event_reader.dequeue();
+	EXPECT_EQ(event.stamp.sequence, 1);
+	EXPECT_EQ(event.value.type(), circuit::events::on);
+
+	// inputs read directly are stamped by the circuit itself
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	EXPECT_EQ(current_reader.dequeue().stamp.device, 9);
+
+	// chained devices carry the stamps on, sensor to circuit to meter
+	typedef tamgef::device::GenericDevice
+		<
+			circuit::amps,
+			double,
+			circuit::state,
+			circuit::events
+		> meter_device;
+
+	meter_device meter(
+			[](circuit::amps) { return true; },
+			[](double) { return true; },
+			[](circuit::amps current) { return current.value; },
+			[](circuit::state state, circuit::amps, double)
+			{
+				return state;
+			},
+			{});
+	QueueReader<meter_device::OutputEnvelope> meter_reader;
+
+	meter.connect(*circuit_device_ptr);
+	meter.connect(meter_reader);
+
+	EXPECT_TRUE(sensor.read(5));
+	EXPECT_TRUE(sensor.read(1));
+	EXPECT_EQ(circuit_device_ptr->pump(4), 2);
+	EXPECT_EQ(meter.pump(4), 2);
+
+	ASSERT_EQ(meter_reader.size(), 2);
+	EXPECT_EQ(meter_reader.dequeue().stamp.sequence, 2);
+
+	auto reading = meter_reader.dequeue();
+	EXPECT_EQ(reading.stamp.device, 7);
+	EXPECT_EQ(reading.stamp.sequence, 3);
+	EXPECT_EQ(reading.value, 0.01);
+}
+
+TEST_F(DeviceTest, envelope_chain)
+{
+	typedef tamgef::device::GenericDevice
+		<
+			double,
+			circuit::volts,
+			circuit::state,
+			circuit::events
+		> sensor_device;
+
+	typedef tamgef::device::GenericDevice
+		<
+			circuit::amps,
+			double,
+			circuit::state,
+			circuit::events
+		> meter_device;
+
+	sensor_device sensor(
+			[](double) { return true; },
+			[](circuit::volts) { return true; },
+			[](double sample) { return circuit::volts(sample); },
+			[](circuit::state state, double, circuit::volts)
+			{
+				return state;
+			},
+			{});
+
+	meter_device meter(
+			[](circuit::amps) { return true; },
+			[](double) { return true; },
+			[](circuit::amps current) { return current.value; },
+			[](circuit::state state, circuit::amps, double)
+			{
+				return state;
+			},
+			{});
+
+	sensor_device const& source = sensor;
+	QueueReader<meter_device::OutputEnvelope> meter_reader;
+
+	// the chain first, the envelope reader at its end last
+	sensor.setDeviceId(1);
+	circuit_device_ptr->setDeviceId(3);
+	circuit_device_ptr->connect(source);
+	meter.connect(*circuit_device_ptr);
+	meter.connect(meter_reader);
+
+	EXPECT_TRUE(sensor.read(5));
+	EXPECT_TRUE(circuit_device_ptr->read());
+	EXPECT_TRUE(meter.read());
+
+	auto reading = meter_reader.dequeue();
+	EXPECT_EQ(reading.stamp.device, 1);
+	EXPECT_EQ(reading.stamp.sequence, 0);
+	EXPECT_EQ(reading.value, 0.05);
+}
+
+TEST_F(DeviceTest, edge_trigger)
+{
+	circuit_device_ptr->connect(*event_queue_reader_ptr);
+
+	EXPECT_THROW(circuit_device_ptr->setTrigger(2, circuit_device::Trigger::Edge),
+			std::out_of_range);
+	EXPECT_THROW(circuit_device_ptr->suppressed(2), std::out_of_range);
+
+	// the broken/none function stays level triggered
+	circuit_device_ptr->setTrigger(1, circuit_device::Trigger::Edge);
+
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(1)));
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(1)));
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+
+	// none, off, none, none, on, none
+	ASSERT_EQ(event_queue_reader_ptr->size(), 6);
+	EXPECT_EQ(circuit_device_ptr->suppressed(), 2);
+	EXPECT_EQ(circuit_device_ptr->suppressed(0), 0);
+	EXPECT_EQ(circuit_device_ptr->suppressed(1), 2);
+
+	event_queue_reader_ptr->dequeue();
+	EXPECT_EQ(event_queue_reader_ptr->dequeue().type(), circuit::events::off);
+	event_queue_reader_ptr->dequeue();
+	event_queue_reader_ptr->dequeue();
+	EXPECT_EQ(event_queue_reader_ptr->dequeue().type(), circuit::events::on);
+
+	// batches are filtered the same way
+	std::vector<circuit::volts> voltages{ 5, 5, 1, 1 };
+
+	circuit_device_ptr->setTrigger(circuit_device::Trigger::Edge);
+	EXPECT_EQ(circuit_device_ptr->read(voltages.data(), voltages.size()), 4);
+	EXPECT_EQ(event_queue_reader_ptr->size(), 1 + 3);
+	EXPECT_EQ(circuit_device_ptr->suppressed(), 2 + 5);
+}
+
+TEST_F(DeviceTest, edge_trigger_late_reader)
+{
+	circuit_device_ptr->setTrigger(1, circuit_device::Trigger::Edge);
+
+	// nobody reads, the trigger still follows the state
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	EXPECT_EQ(circuit_device_ptr->suppressed(), 0);
+
+	circuit_device_ptr->connect(*event_queue_reader_ptr);
+
+	// still on, only the level triggered none is written
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	ASSERT_EQ(event_queue_reader_ptr->size(), 1);
+	EXPECT_EQ(circuit_device_ptr->suppressed(1), 1);
+	EXPECT_EQ(event_queue_reader_ptr->dequeue().type(), circuit::events::none);
+
+	// off in a batch read without a reader, then on again
+	std::vector<circuit::volts> voltages{ 1 };
+
+	event_queue_reader_ptr->disconnect();
+	EXPECT_EQ(circuit_device_ptr->read(voltages.data(), voltages.size()), 1);
+	circuit_device_ptr->connect(*event_queue_reader_ptr);
+
+	EXPECT_TRUE(circuit_device_ptr->read(circuit::volts(5)));
+	ASSERT_EQ(event_queue_reader_ptr->size(), 2);
+	event_queue_reader_ptr->dequeue();
+	EXPECT_EQ(event_queue_reader_ptr->dequeue().type(), circuit::events::on);
+}
+
+// has no default constructor, so is dequeued in place
+struct device_sample
+{
+	explicit device_sample(double value) : value(value) {}
+	double value;
+};
+
+TEST_F(DeviceTest, no_default_constructor)
+{
+	typedef tamgef::device::GenericDevice
+		<
+			device_sample,
+			circuit::volts,
+			circuit::state,
+			circuit::events
+		> sampling_device;
+
+	auto sample_queue_ptr = std::make_shared<Queue<device_sample>>();
+	QueueReader<circuit::volts> voltage_reader;
+
+	sampling_device sampler(
+			[](device_sample) { return true; },
+			[](circuit::volts) { return true; },
+			[](device_sample sample) { return circuit::volts(sample.value); },
+			[](circuit::state state, device_sample, circuit::volts)
+			{
+				return state;
+			},
+			{});
+
+	sampler.connect(QueueReader<device_sample>(sample_queue_ptr));
+	sampler.connect(voltage_reader);
+
+	EXPECT_FALSE(sampler.read());
+	sample_queue_ptr->enqueue(device_sample(1));
+	sample_queue_ptr->enqueue(device_sample(2));
+	sample_queue_ptr->enqueue(device_sample(3));
+
+	EXPECT_TRUE(sampler.read());
+	EXPECT_EQ(sampler.pump(8), 2);
+	EXPECT_EQ(voltage_reader.size(), 3);
+	EXPECT_EQ(voltage_reader.dequeue().value, 1);
+
+	auto static_sampler = tamgef::device::makeStaticDevice<
+		device_sample,
+		circuit::volts,
+		circuit::state,
+		circuit::events>(
+			[](device_sample) { return true; },
+			[](circuit::volts) { return true; },
+			[](device_sample sample) { return circuit::volts(sample.value); },
+			[](circuit::state state, device_sample, circuit::volts)
+			{
+				return state;
+			});
+
+	static_sampler.connect(QueueReader<device_sample>(sample_queue_ptr));
+	sample_queue_ptr->enqueue(device_sample(4));
+	EXPECT_TRUE(static_sampler.read());
+	EXPECT_FALSE(static_sampler.read());
+}
@@ -0,0 +1,96 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <device/domain.h>
+
+using tamgef::device::Domain;
+using tamgef::device::clause;
+
+// tests a packet of samples against 0 <= x <= 2 or 5 <= x <= 6, as a
+// composite predicate one by one or as intervals in one batch
+template<bool Ranged>
+static void domain_test_packet(benchmark::State & state)
+{
+	const size_t packet_size = 64;
+
+	auto domain = Ranged ?
+		Domain<double>::range(0, 2) + Domain<double>::range(5, 6) :
+		Domain<double>([](double x) { return x >= 0; }) *
+			Domain<double>([](double x) { return x <= 2; }) +
+		Domain<double>([](double x) { return x >= 5 && x <= 6; });
+
+	std::vector<double> samples(packet_size);
+	bool mask[packet_size];
+
+	for (size_t i = 0; i < packet_size; ++i)
+		samples[i] = (i % 16) * 0.5;
+
+	while (state.KeepRunning())
+	{
+		if (Ranged)
+			benchmark::DoNotOptimize(
+					domain.test(samples.data(), samples.size(), mask));
+		else
+			for (size_t i = 0; i < packet_size; ++i)
+				benchmark::DoNotOptimize(mask[i] = domain(samples[i]));
+	}
+
+	state.SetItemsProcessed(state.iterations() * packet_size);
+}
+
+BENCHMARK_TEMPLATE(domain_test_packet, false);
+BENCHMARK_TEMPLATE(domain_test_packet, true);
+
+// eight clauses, (a * b) + (c * d) + (e * f) + (g * h), the last term
+// is the only one that holds for the samples tested
+auto const clause_a = [](int x) { return x > 1000; };
+auto const clause_b = [](int x) { return x < 2000; };
+auto const clause_c = [](int x) { return x > 3000; };
+auto const clause_d = [](int x) { return x < 4000; };
+auto const clause_e = [](int x) { return x > 5000; };
+auto const clause_f = [](int x) { return x < 6000; };
+auto const clause_g = [](int x) { return x >= 0; };
+auto const clause_h = [](int x) { return x < 1000; };
+
+static void domain_deep_composite(benchmark::State & state)
+{
+	auto domain =
+		Domain<int>(clause_a) * Domain<int>(clause_b) +
+		Domain<int>(clause_c) * Domain<int>(clause_d) +
+		Domain<int>(clause_e) * Domain<int>(clause_f) +
+		Domain<int>(clause_g) * Domain<int>(clause_h);
+	int sample = 0;
+
+	while (state.KeepRunning())
+		benchmark::DoNotOptimize(domain(++sample & 511));
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+// the same clauses as an expression, erased into a Domain once or
+// called directly
+template<bool Erased>
+static void domain_deep_expression(benchmark::State & state)
+{
+	auto expression =
+		clause(clause_a) * clause(clause_b) +
+		clause(clause_c) * clause(clause_d) +
+		clause(clause_e) * clause(clause_f) +
+		clause(clause_g) * clause(clause_h);
+	Domain<int> domain(expression);
+	int sample = 0;
+
+	while (state.KeepRunning())
+	{
+		if (Erased)
+			benchmark::DoNotOptimize(domain(++sample & 511));
+		else
+			benchmark::DoNotOptimize(expression(++sample & 511));
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(domain_deep_composite);
+BENCHMARK_TEMPLATE(domain_deep_expression, true);
+BENCHMARK_TEMPLATE(domain_deep_expression, false);
@@ -0,0 +1,192 @@
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <device/domain.h>
+#include <gtest/gtest.h>
+
+#include "circuit.h"
+
+using tamgef::device::Domain;
+
+TEST(DomainTest, range)
+{
+	EXPECT_THROW(Domain<double>::range(1, 0), std::invalid_argument);
+
+	auto domain = Domain<double>::range(0, 2);
+
+	EXPECT_TRUE(domain.ranged());
+	EXPECT_TRUE(domain(0));
+	EXPECT_TRUE(domain(2));
+	EXPECT_FALSE(domain(-0.5));
+	EXPECT_FALSE(domain(std::nan("")));
+
+	EXPECT_TRUE(Domain<int>::atLeast(3)(std::numeric_limits<int>::max()));
+	EXPECT_FALSE(Domain<int>::atLeast(3)(2));
+	EXPECT_TRUE(Domain<double>::atMost(3)(-std::numeric_limits<double>::infinity()));
+}
+
+TEST(DomainTest, normalize)
+{
+	// overlapping intervals merge, disjoint ones stay sorted
+	auto domain =
+		Domain<int>::range(10, 20) +
+		Domain<int>::range(0, 5) +
+		Domain<int>::range(4, 8);
+
+	ASSERT_TRUE(domain.ranged());
+	ASSERT_EQ(domain.intervals().size(), 2);
+	EXPECT_EQ(domain.intervals()[0].lower, 0);
+	EXPECT_EQ(domain.intervals()[0].upper, 8);
+	EXPECT_EQ(domain.intervals()[1].lower, 10);
+	EXPECT_FALSE(domain(9));
+
+	auto intersection = domain * Domain<int>::range(6, 12);
+
+	ASSERT_TRUE(intersection.ranged());
+	ASSERT_EQ(intersection.intervals().size(), 2);
+	EXPECT_EQ(intersection.intervals()[0].lower, 6);
+	EXPECT_EQ(intersection.intervals()[1].upper, 12);
+
+	auto empty = Domain<int>::range(0, 1) * Domain<int>::range(2, 3);
+
+	EXPECT_TRUE(empty.ranged());
+	EXPECT_TRUE(empty.intervals().empty());
+	EXPECT_FALSE(empty(0));
+}
+
+TEST(DomainTest, predicate)
+{
+	Domain<int> even([](int value) { return value % 2 == 0; });
+	auto domain = even * Domain<int>::range(0, 10);
+
+	EXPECT_FALSE(domain.ranged());
+	EXPECT_TRUE(domain(4));
+	EXPECT_FALSE(domain(5));
+	EXPECT_FALSE(domain(12));
+	EXPECT_TRUE((even + Domain<int>::range(0, 10))(5));
+
+	// non-arithmetic types only have predicates
+	Domain<circuit::volts> positive(
+			[](circuit::volts voltage) { return voltage.value >= 0; });
+	auto composite = positive * positive;
+
+	EXPECT_TRUE(composite(circuit::volts(1)));
+	EXPECT_FALSE(composite(circuit::volts(-1)));
+
+	// no predicate at all
+	Domain<int> undefined;
+
+	EXPECT_THROW(undefined(0), std::bad_function_call);
+}
+
+TEST(DomainTest, composition)
+{
+	int calls = 0;
+	Domain<int> positive([&calls](int value) { ++calls; return value > 0; });
+	Domain<int> even([&calls](int value) { ++calls; return value % 2 == 0; });
+	Domain<int> small([&calls](int value) { ++calls; return value < 10; });
+
+	auto domain = (positive + even) * small;
+
+	EXPECT_EQ(domain.terms(), 3);
+	EXPECT_TRUE(domain(3));
+	EXPECT_TRUE(domain(-2));
+	EXPECT_FALSE(domain(-3));
+	EXPECT_FALSE(domain(12));
+
+	// short-circuits like || and &&
+	calls = 0;
+	EXPECT_TRUE(domain(3));
+	EXPECT_EQ(calls, 2);
+
+	calls = 0;
+	EXPECT_FALSE(domain(-3));
+	EXPECT_EQ(calls, 2);
+
+	// a ranged domain joins as a single term
+	auto bounded = domain + Domain<int>::range(100, 200) * even;
+
+	EXPECT_EQ(bounded.terms(), 5);
+	EXPECT_TRUE(bounded(150));
+	EXPECT_FALSE(bounded(151));
+	EXPECT_EQ(Domain<int>::range(0, 1).terms(), 0);
+
+	// intersections aren't multiplied out, each term runs at most once
+	auto product = positive + even;
+
+	for (int i = 1; i < 10; ++i)
+		product = product * (positive + even);
+
+	EXPECT_EQ(product.terms(), 20);
+
+	calls = 0;
+	EXPECT_FALSE(product(-3));
+	EXPECT_EQ(calls, 2);
+
+	calls = 0;
+	EXPECT_TRUE(product(3));
+	EXPECT_EQ(calls, 10);
+
+	calls = 0;
+	EXPECT_TRUE(product(-2));
+	EXPECT_EQ(calls, 20);
+}
+
+TEST(DomainTest, test)
+{
+	auto domain = Domain<double>::range(0, 2) + Domain<double>::range(5, 6);
+	std::vector<double> voltages{ -1, 0, 1, 3, 5, 6, 7, std::nan(""), 1.5 };
+	std::vector<bool> expected{ 0, 1, 1, 0, 1, 1, 0, 0, 1 };
+	bool mask[9];
+
+	EXPECT_EQ(domain.test(voltages.data(), voltages.size(), mask), 5);
+
+	for (size_t i = 0; i < voltages.size(); ++i)
+		EXPECT_EQ(mask[i], expected[i]) << "at " << i;
+
+	std::vector<float> currents(voltages.begin(), voltages.end());
+
+	EXPECT_EQ(Domain<float>::range(0, 2).test(currents.data(), currents.size(), mask), 3);
+	EXPECT_TRUE(mask[8]);
+
+	Domain<double> predicate([](double value) { return value > 4; });
+
+	EXPECT_EQ(predicate.test(voltages.data(), voltages.size(), mask), 3);
+	EXPECT_FALSE(mask[7]);
+}
+
+TEST(DomainTest, expression)
+{
+	using tamgef::device::clause;
+
+	int calls = 0;
+	auto positive = clause([&calls](int value) { ++calls; return value > 0; });
+	auto even = clause([&calls](int value) { ++calls; return value % 2 == 0; });
+	auto small = clause([&calls](int value) { ++calls; return value < 10; });
+	auto expression = positive * even + small * positive;
+
+	EXPECT_TRUE(expression(4));
+	EXPECT_TRUE(expression(3));
+	EXPECT_FALSE(expression(12 + 1));
+	EXPECT_FALSE(expression(-2));
+
+	// short-circuits, the second term only runs when the first fails
+	calls = 0;
+	EXPECT_TRUE(expression(4));
+	EXPECT_EQ(calls, 2);
+
+	Domain<int> domain(expression);
+
+	EXPECT_FALSE(domain.ranged());
+	EXPECT_TRUE(domain(3));
+	EXPECT_FALSE(domain(-3));
+
+	// domains are clauses too
+	auto bounded = clause(Domain<int>::range(0, 100)) * even;
+
+	EXPECT_TRUE(bounded(50));
+	EXPECT_FALSE(bounded(102));
+}
@@ -0,0 +1,103 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <device/event.h>
+#include <queue/queue.h>
+
+using tamgef::device::Event;
+using tamgef::device::EventRecord;
+
+enum class gesture : uint16_t {};
+
+const int gesture_count = 200;
+
+static void event_register_gestures()
+{
+	for (int i = 0; i < gesture_count; ++i)
+		Event<gesture>::registerType(static_cast<gesture>(i));
+}
+
+// constructs events of the last registered gesture types, the worst
+// case of a linear search
+static void event_construct(benchmark::State & state)
+{
+	event_register_gestures();
+	int i = 0;
+
+	while (state.KeepRunning())
+	{
+		Event<gesture> event(static_cast<gesture>(gesture_count - 1 - (++i & 7)));
+		benchmark::DoNotOptimize(event);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+static void event_copy(benchmark::State & state)
+{
+	event_register_gestures();
+	Event<gesture> event(static_cast<gesture>(gesture_count - 1));
+
+	while (state.KeepRunning())
+	{
+		Event<gesture> copy(event);
+		benchmark::DoNotOptimize(copy);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+static void event_construct_hashed(benchmark::State & state)
+{
+	std::vector<std::string> names;
+
+	for (int i = 0; i < gesture_count; ++i)
+	{
+		names.push_back("gesture " + std::to_string(i));
+		Event<std::string>::registerType(names.back());
+	}
+
+	int i = 0;
+
+	while (state.KeepRunning())
+	{
+		Event<std::string> event(names[gesture_count - 1 - (++i & 7)]);
+		benchmark::DoNotOptimize(event);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+// moves packets of 64 events through a queue in bulk, as Events or as
+// compact records
+template<typename EventT>
+static void event_bulk_transfer(benchmark::State & state)
+{
+	const size_t packet_size = 64;
+	event_register_gestures();
+
+	tamgef::queue::Queue<EventT> queue;
+	std::vector<EventT> events;
+	std::vector<EventT> received(packet_size);
+
+	for (size_t i = 0; i < packet_size; ++i)
+		events.push_back(EventT(Event<gesture>(static_cast<gesture>(i)).record()));
+
+	while (state.KeepRunning())
+	{
+		queue.enqueueBulk(events.data(), events.size());
+		benchmark::DoNotOptimize(
+				queue.tryDequeueBulk(received.data(), received.size()));
+	}
+
+	state.SetItemsProcessed(state.iterations() * packet_size);
+	state.SetLabel(std::to_string(sizeof(EventT)) + " bytes");
+}
+
+BENCHMARK(event_construct);
+BENCHMARK(event_copy);
+BENCHMARK(event_construct_hashed);
+BENCHMARK_TEMPLATE(event_bulk_transfer, Event<gesture>);
+BENCHMARK_TEMPLATE(event_bulk_transfer, EventRecord<gesture>);
@@ -0,0 +1,166 @@
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <thread>
+
+#include <device/event.h>
+#include <gtest/gtest.h>
+#include <queue/ring_queue.h>
+
+using tamgef::device::Event;
+
+enum class swipe : int
+{
+	left = -1,
+	right = 1,
+	up = 70000,
+	down = 2
+};
+
+TEST(EventTest, register_enum)
+{
+	Event<swipe>::registerType({ swipe::left, swipe::right, swipe::up });
+	Event<swipe>::registerType(swipe::right);
+
+	EXPECT_TRUE(Event<swipe>::registered(swipe::left));
+	EXPECT_TRUE(Event<swipe>::registered(swipe::right));
+	EXPECT_TRUE(Event<swipe>::registered(swipe::up));
+	EXPECT_FALSE(Event<swipe>::registered(swipe::down));
+	EXPECT_EQ(Event<swipe>::registeredTypes().size(), 3);
+
+	EXPECT_NO_THROW(Event<swipe>(swipe::up));
+	EXPECT_THROW(Event<swipe>(swipe::down), std::invalid_argument);
+}
+
+TEST(EventTest, register_hashed)
+{
+	Event<std::string>::registerType({ "tap", "pinch" });
+
+	EXPECT_TRUE(Event<std::string>::registered("tap"));
+	EXPECT_FALSE(Event<std::string>::registered("rotate"));
+	EXPECT_THROW(Event<std::string>("rotate"), std::invalid_argument);
+	EXPECT_EQ(Event<std::string>("pinch").type(), "pinch");
+}
+
+// comparable, but std::hash can't hash it
+struct stroke
+{
+	std::string name;
+
+	bool operator==(stroke const& other) const
+	{
+		return name == other.name;
+	}
+};
+
+TEST(EventTest, register_unhashed)
+{
+	static_assert(!tamgef::device::Hashable<stroke>::value,
+			"stroke has no std::hash");
+	static_assert(tamgef::device::Hashable<std::string>::value,
+			"strings are hashed");
+
+	Event<stroke>::registerType({ stroke{ "tap" }, stroke{ "pinch" } });
+	Event<stroke>::registerType(stroke{ "tap" });
+
+	EXPECT_TRUE(Event<stroke>::registered(stroke{ "pinch" }));
+	EXPECT_FALSE(Event<stroke>::registered(stroke{ "rotate" }));
+	EXPECT_EQ(Event<stroke>::registeredTypes().size(), 2);
+	EXPECT_THROW(Event<stroke>(stroke{ "rotate" }), std::invalid_argument);
+}
+
+TEST(EventTest, copy)
+{
+	Event<swipe>::registerType(swipe::left);
+
+	Event<swipe> event(swipe::left);
+	event.lower();
+
+	// copies of a valid event skip the registry
+	Event<swipe> copy(event);
+	Event<swipe> moved(std::move(copy));
+
+	EXPECT_EQ(moved.type(), swipe::left);
+	moved.raise();
+	moved = event;
+	EXPECT_EQ(moved.type(), swipe::left);
+}
+
+enum class plugin_gesture : int {};
+
+TEST(EventTest, register_concurrent)
+{
+	const int types = 1000;
+
+	Event<plugin_gesture>::registerType(static_cast<plugin_gesture>(0));
+
+	// registers while the main thread keeps constructing events
+	std::thread plugin_loader([&]()
+			{
+				for (int i = 1; i < types; ++i)
+					Event<plugin_gesture>::registerType(
+							static_cast<plugin_gesture>(i));
+			});
+
+	int seen = 0;
+
+	while (seen < types - 1)
+	{
+		// a type stays registered once seen
+		for (int i = 0; i <= seen; ++i)
+			ASSERT_NO_THROW(Event<plugin_gesture>(
+						static_cast<plugin_gesture>(i)));
+
+		if (Event<plugin_gesture>::registered(
+					static_cast<plugin_gesture>(seen + 1)))
+			++seen;
+	}
+
+	plugin_loader.join();
+
+	// in registration order
+	auto registered = Event<plugin_gesture>::registeredTypes();
+
+	ASSERT_EQ(registered.size(), types);
+
+	for (int i = 0; i < types; ++i)
+		ASSERT_EQ(registered[i], static_cast<plugin_gesture>(i));
+}
+
+TEST(EventTest, record)
+{
+	static_assert(std::is_trivially_copyable<tamgef::device::EventRecord<swipe>>::value,
+			"Event records must be trivially copyable");
+	static_assert(sizeof(tamgef::device::EventRecord<swipe>) <= 16,
+			"Event records must fit 16 bytes");
+
+	Event<swipe>::registerType(swipe::right);
+
+	Event<swipe> event(swipe::right);
+	event.lower();
+
+	auto before = tamgef::device::monotonicTime();
+	auto record = event.record();
+
+	EXPECT_GE(record.timestamp, before);
+	EXPECT_LE(record.timestamp, tamgef::device::monotonicTime());
+	EXPECT_EQ(record.type, swipe::right);
+	EXPECT_FALSE(record.flag);
+
+	// round trip through a bulk queue
+	tamgef::queue::RingQueue<tamgef::device::EventRecord<swipe>> ring_queue(4);
+	tamgef::device::EventRecord<swipe> records[2] = { record, record };
+	records[1].flag = true;
+
+	ring_queue.enqueueBulk(records, 2);
+	ASSERT_EQ(ring_queue.tryDequeueBulk(records, 2), 2);
+
+	Event<swipe> copy(records[1]);
+
+	EXPECT_EQ(copy.type(), swipe::right);
+	EXPECT_TRUE(copy.raised());
+	EXPECT_FALSE(Event<swipe>(records[0]).raised());
+
+	records[0].type = swipe::down;
+	EXPECT_THROW(Event<swipe>{ records[0] }, std::invalid_argument);
+}
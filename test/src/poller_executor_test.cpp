@@ -0,0 +1,175 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <observer/iobserver.h>
+#include <queue/poller_executor.h>
+#include <queue/queue.h>
+#include <queue/queue_observer.h>
+#include <queue/queue_poller.h>
+#include <queue/queue_reader.h>
+
+TEST(PollerExecutorTest, constructor)
+{
+	EXPECT_THROW(tamgef::queue::PollerExecutor(0), std::invalid_argument);
+	EXPECT_THROW(tamgef::queue::PollerExecutor(1, 0), std::invalid_argument);
+	EXPECT_THROW(tamgef::queue::PollerExecutor(1, 1, nullptr), 
+			std::invalid_argument);
+
+	tamgef::queue::PollerExecutor executor(2);
+	EXPECT_EQ(executor.workers(), 2);
+	EXPECT_EQ(executor.size(), 0);
+}
+
+TEST(PollerExecutorTest, add_remove)
+{
+	auto timeout(std::chrono::milliseconds(10));
+	tamgef::queue::PollerExecutor executor(2, 4);
+	std::atomic<size_t> budget(0);
+
+	EXPECT_THROW(executor.add(tamgef::queue::PollerExecutor::Task()), 
+			std::invalid_argument);
+	EXPECT_THROW(executor.add([](size_t) { return 0; }, 0), 
+			std::invalid_argument);
+
+	auto id = executor.add(
+			[&budget](size_t b) -> size_t
+			{ 
+				budget.store(b);
+				return 0; 
+			}, 
+			3);
+
+	EXPECT_EQ(executor.size(), 1);
+
+	// I know, I know
+	std::this_thread::sleep_for(timeout);
+	EXPECT_EQ(budget.load(), 12);
+
+	executor.remove(id);
+	EXPECT_EQ(executor.size(), 0);
+
+	// not run after removal
+	budget.store(0);
+	std::this_thread::sleep_for(timeout);
+	EXPECT_EQ(budget.load(), 0);
+}
+
+TEST(PollerExecutorTest, remove_from_task)
+{
+	auto timeout(std::chrono::milliseconds(10));
+	tamgef::queue::PollerExecutor executor(2);
+	std::atomic<size_t> self_id(0), first_id(0), second_id(0);
+	std::atomic<size_t> self_runs(0);
+	std::atomic<bool> ready(false);
+
+	// removes itself while running
+	self_id = executor.add(
+			[&](size_t) -> size_t
+			{
+				if (!ready.load())
+					return 0;
+
+				self_runs.fetch_add(1);
+				executor.remove(self_id.load());
+				return 1;
+			});
+
+	// remove each other, possibly at the same time on both workers
+	first_id = executor.add(
+			[&](size_t) -> size_t
+			{
+				if (ready.load())
+					executor.remove(second_id.load());
+				return 0;
+			});
+	second_id = executor.add(
+			[&](size_t) -> size_t
+			{
+				if (ready.load())
+					executor.remove(first_id.load());
+				return 0;
+			});
+	ready.store(true);
+
+	// I know, I know
+	std::this_thread::sleep_for(timeout);
+	EXPECT_EQ(self_runs.load(), 1);
+
+	// whichever of the pair ran first is left, unless both ran at once
+	EXPECT_LE(executor.size(), 1);
+}
+
+TEST(PollerExecutorTest, queue_poller)
+{
+	const int streams(100);
+	auto timeout(std::chrono::milliseconds(50));
+	tamgef::queue::PollerExecutor executor(4);
+	std::atomic<int> recieved(0);
+	std::vector<std::shared_ptr<tamgef::queue::Queue<int>>> queues;
+	std::vector<std::unique_ptr<tamgef::queue::QueuePoller<int>>> pollers;
+
+	for (int i = 0; i < streams; ++i)
+	{
+		queues.push_back(std::make_shared<tamgef::queue::Queue<int>>());
+		pollers.emplace_back(new tamgef::queue::QueuePoller<int>(
+				tamgef::queue::QueueReader<int>(queues.back()),
+				[&recieved](int message) 
+				{ 
+					recieved.fetch_add(message); 
+				},
+				executor));
+	}
+
+	EXPECT_EQ(executor.size(), streams);
+
+	for (auto & queue_ptr : queues)
+		queue_ptr->enqueue(1);
+
+	std::this_thread::sleep_for(timeout);
+	EXPECT_EQ(recieved.load(), streams);
+
+	// errors are reported through the poller
+	queues.front().reset();
+	std::this_thread::sleep_for(timeout);
+	EXPECT_FALSE(pollers.front()->polling());
+	EXPECT_TRUE(pollers.front()->error());
+
+	pollers.clear();
+	EXPECT_EQ(executor.size(), 0);
+}
+
+TEST(PollerExecutorTest, queue_observer)
+{
+	class counter : public tamgef::observer::IObserver<int>
+	{
+	public:
+		counter() : count(0) {}
+
+		bool update(int message) override
+		{
+			count.fetch_add(message);
+			return true;
+		}
+
+		std::atomic<int> count;
+	};
+
+	auto timeout(std::chrono::milliseconds(10));
+	auto counter_ptr = std::make_shared<counter>();
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<int>>();
+	tamgef::queue::PollerExecutor executor(1);
+
+	tamgef::queue::QueueObserver<int> queue_observer(
+			tamgef::queue::QueueReader<int>(queue_ptr),
+			{ counter_ptr },
+			executor);
+
+	queue_ptr->enqueue(2);
+	std::this_thread::sleep_for(timeout);
+
+	EXPECT_EQ(counter_ptr->count.load(), 2);
+}
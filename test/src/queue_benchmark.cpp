@@ -0,0 +1,372 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <queue/broadcast_queue.h>
+#include <queue/queue.h>
+#include <queue/queue_reader.h>
+#include <queue/ring_queue.h>
+
+// multi-touch frame, ten contacts of x, y and pressure
+struct touch_frame
+{
+	std::array<float, 30> contacts;
+};
+
+// hand tracking frame, joints, confidences and a depth image
+struct hand_frame
+{
+	std::array<float, 26 * 7> joints;
+	std::array<float, 26> confidences;
+	std::array<uint8_t, 64 * 64> image;
+};
+
+template<typename T>
+static void queue_enqueue_dequeue(benchmark::State & state)
+{
+	tamgef::queue::Queue<T> queue;
+	std::vector<T> elements(state.range_x());
+
+	while (state.KeepRunning())
+	{
+		for (auto & element : elements)
+			queue.enqueue(element);
+
+		for (auto & element : elements)
+			element = queue.dequeue();
+	}
+
+	state.SetItemsProcessed(
+			static_cast<int64_t>(state.iterations()) * state.range_x());
+}
+
+template<typename T>
+static void queue_enqueue_dequeue_bulk(benchmark::State & state)
+{
+	tamgef::queue::Queue<T> queue;
+	std::vector<T> elements(state.range_x());
+
+	while (state.KeepRunning())
+	{
+		queue.enqueueBulk(elements.data(), elements.size());
+		queue.tryDequeueBulk(elements.data(), elements.size());
+	}
+
+	state.SetItemsProcessed(
+			static_cast<int64_t>(state.iterations()) * state.range_x());
+}
+
+template<typename T>
+static void queue_reader_dequeue(benchmark::State & state)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<T>>();
+	tamgef::queue::QueueReader<T> queue_reader(queue_ptr);
+	std::vector<T> elements(state.range_x());
+
+	while (state.KeepRunning())
+	{
+		queue_ptr->enqueueBulk(elements.data(), elements.size());
+
+		for (auto & element : elements)
+			element = queue_reader.dequeue();
+	}
+
+	state.SetItemsProcessed(
+			static_cast<int64_t>(state.iterations()) * state.range_x());
+}
+
+template<typename T>
+static void queue_reader_dequeue_bulk(benchmark::State & state)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<T>>();
+	tamgef::queue::QueueReader<T> queue_reader(queue_ptr);
+	std::vector<T> elements(state.range_x());
+
+	while (state.KeepRunning())
+	{
+		queue_ptr->enqueueBulk(elements.data(), elements.size());
+		queue_reader.tryDequeueBulk(elements.data(), elements.size());
+	}
+
+	state.SetItemsProcessed(
+			static_cast<int64_t>(state.iterations()) * state.range_x());
+}
+
+// per-element reads through a reader, locking the queue on each call
+// or once per batch through a pinned session; readers share the queue's
+// reference count as a poller's and a device's would
+static std::shared_ptr<tamgef::queue::Queue<int>> pinned_queue_ptr =
+	std::make_shared<tamgef::queue::Queue<int>>();
+
+template<bool UsePin>
+static void queue_reader_pin(benchmark::State & state)
+{
+	tamgef::queue::QueueReader<int> queue_reader(pinned_queue_ptr);
+	auto consumer = queue_reader.consumer();
+	std::vector<int> elements(state.range_x());
+
+	while (state.KeepRunning())
+	{
+		pinned_queue_ptr->enqueueBulk(elements.data(), elements.size());
+
+		if (UsePin)
+		{
+			auto pinned = consumer.pin();
+
+			for (auto & element : elements)
+				pinned.tryDequeue(element);
+		}
+		else
+			for (auto & element : elements)
+				consumer.tryDequeue(element);
+	}
+
+	state.SetItemsProcessed(
+			static_cast<int64_t>(state.iterations()) * state.range_x());
+}
+
+// fans touch frames out to range_x readers, copying into a queue per
+// reader as observers do, or viewing them in place in a broadcast queue
+template<bool UseBroadcast>
+static void queue_fan_out(benchmark::State & state)
+{
+	const size_t readers(state.range_x());
+	std::vector<touch_frame> elements(64);
+	std::vector<touch_frame> recieved(elements.size());
+
+	tamgef::queue::BroadcastQueue<touch_frame> broadcast(elements.size());
+	std::vector<std::shared_ptr<tamgef::queue::BroadcastQueue<touch_frame>::Cursor>> 
+		cursors;
+	std::vector<std::shared_ptr<tamgef::queue::Queue<touch_frame>>> queues;
+
+	for (size_t i = 0; i < readers; ++i)
+	{
+		cursors.push_back(broadcast.cursor());
+		queues.push_back(std::make_shared<tamgef::queue::Queue<touch_frame>>());
+	}
+
+	while (state.KeepRunning())
+	{
+		if (UseBroadcast)
+		{
+			broadcast.enqueueBulk(elements.data(), elements.size());
+
+			for (auto & cursor : cursors)
+			{
+				const touch_frame* first;
+				size_t count;
+
+				while ((count = cursor->view(first)) != 0)
+				{
+					benchmark::DoNotOptimize(first);
+					cursor->release(count);
+				}
+			}
+		}
+		else
+			for (auto & queue : queues)
+			{
+				queue->enqueueBulk(elements.data(), elements.size());
+				queue->tryDequeueBulk(recieved.data(), recieved.size());
+			}
+	}
+
+	state.SetItemsProcessed(
+			static_cast<int64_t>(state.iterations()) * elements.size());
+}
+
+// passes range_x frames through a ring, copied in and out or filled
+// and read in place through slot loans
+template<bool UseLoan>
+static void ring_queue_loan(benchmark::State & state)
+{
+	tamgef::queue::RingQueue<hand_frame> queue(state.range_x());
+	hand_frame element = hand_frame();
+	uint8_t sum(0);
+
+	while (state.KeepRunning())
+	{
+		for (int i = 0; i < state.range_x(); ++i)
+		{
+			if (UseLoan)
+			{
+				auto slot = queue.claim();
+				slot->image[i] = uint8_t(i);
+				queue.commit();
+			}
+			else
+			{
+				element.image[i] = uint8_t(i);
+				queue.enqueue(element);
+			}
+		}
+
+		for (int i = 0; i < state.range_x(); ++i)
+		{
+			if (UseLoan)
+			{
+				const hand_frame* first;
+				queue.view(first);
+				sum += first->image[i];
+				queue.release(1);
+			}
+			else
+			{
+				queue.tryDequeue(element);
+				sum += element.image[i];
+			}
+		}
+	}
+
+	benchmark::DoNotOptimize(sum);
+	state.SetItemsProcessed(
+			static_cast<int64_t>(state.iterations()) * state.range_x());
+}
+
+// shared by all benchmark threads, so must outlive their setup
+static tamgef::queue::Queue<int> shared_queue;
+
+static void queue_multi_producer(benchmark::State & state)
+{
+	int element(state.thread_index);
+
+	while (state.KeepRunning())
+	{
+		shared_queue.enqueue(element);
+		shared_queue.tryDequeueBulk(&element, 1);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+static void queue_multi_producer_session(benchmark::State & state)
+{
+	auto producer = shared_queue.producer();
+	auto consumer = shared_queue.consumer();
+	int element(state.thread_index);
+
+	while (state.KeepRunning())
+	{
+		producer->enqueue(element);
+		consumer->tryDequeue(element);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+template<typename QueueT>
+static std::shared_ptr<QueueT> make_queue();
+
+template<>
+std::shared_ptr<tamgef::queue::Queue<int>> make_queue()
+{
+	return std::make_shared<tamgef::queue::Queue<int>>();
+}
+
+template<>
+std::shared_ptr<tamgef::queue::RingQueue<int>> make_queue()
+{
+	return std::make_shared<tamgef::queue::RingQueue<int>>(1024);
+}
+
+// one iteration is two hops, ping to an echo thread and back again
+template<typename QueueT>
+static void queue_round_trip(benchmark::State & state)
+{
+	auto ping = make_queue<QueueT>();
+	auto pong = make_queue<QueueT>();
+	std::atomic<bool> running(true);
+
+	std::thread echo([&]
+			{
+				auto consumer = ping->consumer();
+				auto producer = pong->producer();
+				int element;
+
+				while (running.load(std::memory_order_relaxed))
+				{
+					if (consumer->tryDequeue(element))
+						producer->enqueue(element);
+					else
+						std::this_thread::yield();
+				}
+			});
+
+	auto consumer = pong->consumer();
+	auto producer = ping->producer();
+	int element(0);
+
+	while (state.KeepRunning())
+	{
+		producer->enqueue(element);
+
+		while (!consumer->tryDequeue(element))
+			std::this_thread::yield();
+	}
+
+	running.store(false);
+	echo.join();
+}
+
+// as queue_round_trip, but both ends park on the queue while it's empty
+template<typename QueueT>
+static void queue_round_trip_wait(benchmark::State & state)
+{
+	const std::chrono::milliseconds timeout(1);
+	auto ping = make_queue<QueueT>();
+	auto pong = make_queue<QueueT>();
+	std::atomic<bool> running(true);
+
+	std::thread echo([&]
+			{
+				auto consumer = ping->consumer();
+				auto producer = pong->producer();
+				int element;
+
+				while (running.load(std::memory_order_relaxed))
+				{
+					if (consumer->tryDequeue(element))
+						producer->enqueue(element);
+					else
+						ping->wait(timeout);
+				}
+			});
+
+	auto consumer = pong->consumer();
+	auto producer = ping->producer();
+	int element(0);
+
+	while (state.KeepRunning())
+	{
+		producer->enqueue(element);
+
+		while (!consumer->tryDequeue(element))
+			pong->wait(timeout);
+	}
+
+	running.store(false);
+	echo.join();
+}
+
+BENCHMARK_TEMPLATE(queue_enqueue_dequeue, int)->Range(1, 1 << 10);
+BENCHMARK_TEMPLATE(queue_enqueue_dequeue_bulk, int)->Range(1, 1 << 10);
+BENCHMARK_TEMPLATE(queue_enqueue_dequeue, touch_frame)->Range(1, 1 << 10);
+BENCHMARK_TEMPLATE(queue_enqueue_dequeue_bulk, touch_frame)->Range(1, 1 << 10);
+BENCHMARK_TEMPLATE(queue_reader_dequeue, touch_frame)->Range(1, 1 << 10);
+BENCHMARK_TEMPLATE(queue_reader_dequeue_bulk, touch_frame)->Range(1, 1 << 10);
+BENCHMARK_TEMPLATE(queue_reader_pin, false)->Arg(64)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(queue_reader_pin, true)->Arg(64)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(queue_fan_out, false)->Arg(1)->Arg(3)->Arg(8);
+BENCHMARK_TEMPLATE(queue_fan_out, true)->Arg(1)->Arg(3)->Arg(8);
+BENCHMARK_TEMPLATE(ring_queue_loan, false)->Arg(16)->Arg(256);
+BENCHMARK_TEMPLATE(ring_queue_loan, true)->Arg(16)->Arg(256);
+BENCHMARK(queue_multi_producer)->ThreadRange(1, 16);
+BENCHMARK(queue_multi_producer_session)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(queue_round_trip, tamgef::queue::Queue<int>);
+BENCHMARK_TEMPLATE(queue_round_trip, tamgef::queue::RingQueue<int>);
+BENCHMARK_TEMPLATE(queue_round_trip_wait, tamgef::queue::Queue<int>);
+BENCHMARK_TEMPLATE(queue_round_trip_wait, tamgef::queue::RingQueue<int>);
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <queue/poller_executor.h>
+#include <queue/queue.h>
+#include <queue/queue_poller.h>
+#include <queue/queue_reader.h>
+#include <queue/wait_strategy.h>
+
+typedef std::chrono::steady_clock::time_point time_point;
+
+// wake-up latency of a poller after range_x microseconds of idling,
+// labelled with the mean latency and process cpu use over the run
+template<typename WaitStrategyT>
+static void queue_poller_wake_up(benchmark::State & state)
+{
+	const std::chrono::microseconds idle(state.range_x());
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<time_point>>();
+	std::atomic<int64_t> latency(0);
+	std::atomic<int64_t> recieved(0);
+
+	tamgef::queue::QueuePoller<time_point> queue_poller(
+			tamgef::queue::QueueReader<time_point>(queue_ptr),
+			[&](time_point sent)
+			{
+				auto elapsed = std::chrono::steady_clock::now() - sent;
+				latency.fetch_add(
+						std::chrono::duration_cast<std::chrono::nanoseconds>(
+							elapsed).count());
+				recieved.fetch_add(1);
+			},
+			std::make_shared<WaitStrategyT>());
+
+	auto wall_start = std::chrono::steady_clock::now();
+	auto cpu_start = std::clock();
+	int64_t sent(0);
+
+	while (state.KeepRunning())
+	{
+		std::this_thread::sleep_for(idle);
+		queue_ptr->enqueue(std::chrono::steady_clock::now());
+		++sent;
+
+		while (recieved.load() != sent)
+			std::this_thread::yield();
+	}
+
+	auto wall = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - wall_start).count();
+	auto cpu = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+	std::ostringstream label;
+	label << "latency " << latency.load() / std::max<int64_t>(sent, 1)
+		<< "ns, cpu " << int(100 * cpu / wall) << "%";
+	state.SetLabel(label.str());
+}
+
+BENCHMARK_TEMPLATE(queue_poller_wake_up, tamgef::queue::BusySpinWait)
+	->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK_TEMPLATE(queue_poller_wake_up, tamgef::queue::YieldWait)
+	->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK_TEMPLATE(queue_poller_wake_up, tamgef::queue::BackoffWait)
+	->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK_TEMPLATE(queue_poller_wake_up, tamgef::queue::ParkWait)
+	->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK_TEMPLATE(queue_poller_wake_up, tamgef::queue::AdaptiveWait)
+	->Arg(10)->Arg(100)->Arg(1000);
+
+// delivers one message to each of range_x streams per iteration, either
+// polled by an eight worker executor or by one thread per stream
+template<bool UseExecutor>
+static void queue_poller_streams(benchmark::State & state)
+{
+	const int streams(state.range_x());
+	tamgef::queue::PollerExecutor executor(8);
+	std::atomic<int64_t> recieved(0);
+	std::vector<std::shared_ptr<tamgef::queue::Queue<int>>> queues;
+	std::vector<std::unique_ptr<tamgef::queue::QueuePoller<int>>> pollers;
+
+	auto handler = [&recieved](int) { recieved.fetch_add(1); };
+
+	for (int i = 0; i < streams; ++i)
+	{
+		queues.push_back(std::make_shared<tamgef::queue::Queue<int>>());
+		tamgef::queue::QueueReader<int> queue_reader(queues.back());
+
+		if (UseExecutor)
+			pollers.emplace_back(new tamgef::queue::QueuePoller<int>(
+					queue_reader, handler, executor));
+		else
+			pollers.emplace_back(new tamgef::queue::QueuePoller<int>(
+					queue_reader, handler));
+	}
+
+	int64_t sent(0);
+
+	while (state.KeepRunning())
+	{
+		for (auto & queue_ptr : queues)
+			queue_ptr->enqueue(0);
+
+		sent += streams;
+
+		while (recieved.load() != sent)
+			std::this_thread::yield();
+	}
+
+	pollers.clear();
+	state.SetItemsProcessed(sent);
+}
+
+BENCHMARK_TEMPLATE(queue_poller_streams, true)->Arg(16)->Arg(128)->Arg(512);
+BENCHMARK_TEMPLATE(queue_poller_streams, false)->Arg(16)->Arg(128);
+
+// delivers range_x messages per iteration through a per-message
+// handler or a batch handler
+template<bool UseBatch>
+static void queue_poller_handler(benchmark::State & state)
+{
+	const int sent(state.range_x());
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<int>>();
+	tamgef::queue::QueueReader<int> queue_reader(queue_ptr);
+	std::vector<int> messages(sent);
+	std::atomic<int64_t> recieved(0);
+	int64_t total(0);
+
+	std::unique_ptr<tamgef::queue::QueuePoller<int>> queue_poller;
+
+	if (UseBatch)
+		queue_poller.reset(new tamgef::queue::QueuePoller<int>(
+				queue_reader,
+				[&recieved](int const*, size_t count) 
+				{ 
+					recieved.fetch_add(count); 
+				},
+				256));
+	else
+		queue_poller.reset(new tamgef::queue::QueuePoller<int>(
+				queue_reader,
+				[&recieved](int) 
+				{ 
+					recieved.fetch_add(1); 
+				}));
+
+	while (state.KeepRunning())
+	{
+		queue_ptr->enqueueBulk(messages.data(), messages.size());
+		total += sent;
+
+		while (recieved.load() != total)
+			std::this_thread::yield();
+	}
+
+	queue_poller.reset();
+	state.SetItemsProcessed(total);
+}
+
+BENCHMARK_TEMPLATE(queue_poller_handler, false)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(queue_poller_handler, true)->Arg(64)->Arg(1024);
@@ -1,5 +1,6 @@
 #include <atomic>
 #include <chrono>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <queue/queue.h>
@@ -81,3 +82,145 @@ TEST(QueuePollerTest, poll)
 	EXPECT_EQ(recieved.load(), sent);
 }
 
+TEST(QueuePollerTest, wait_strategy)
+{
+	auto timeout(std::chrono::milliseconds(10));
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<int>>();
+
+	EXPECT_THROW(
+		{
+			tamgef::queue::QueuePoller<int> queue_poller(
+					(tamgef::queue::QueueReader<int>(queue_ptr)),
+					([](int){}),
+					(std::shared_ptr<tamgef::queue::WaitStrategy const>()));
+		}, 
+		std::invalid_argument);
+
+	std::vector<std::shared_ptr<tamgef::queue::WaitStrategy const>> strategies
+	({
+		std::make_shared<tamgef::queue::BusySpinWait>(),
+		std::make_shared<tamgef::queue::YieldWait>(),
+		std::make_shared<tamgef::queue::BackoffWait>(),
+		std::make_shared<tamgef::queue::ParkWait>(),
+		std::make_shared<tamgef::queue::AdaptiveWait>()
+	});
+
+	for (auto & strategy : strategies)
+	{
+		std::atomic<int> recieved(0);
+
+		tamgef::queue::QueuePoller<int> queue_poller(
+				tamgef::queue::QueueReader<int>(queue_ptr),
+				[&recieved](int message) 
+				{ 
+					recieved.store(message); 
+				},
+				strategy);
+
+		// I know, I know 
+		std::this_thread::sleep_for(timeout);
+		EXPECT_GT(queue_poller.idleSpins(), 0);
+
+		queue_ptr->enqueue(1);
+		std::this_thread::sleep_for(timeout);
+		EXPECT_EQ(recieved.load(), 1);
+	}
+}
+
+TEST(QueuePollerTest, batch)
+{
+	typedef tamgef::queue::QueuePoller<int>::BatchHandler batch_handler;
+
+	const int sent(1000);
+	auto timeout(std::chrono::milliseconds(50));
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<int>>();
+	tamgef::queue::QueueReader<int> queue_reader(queue_ptr);
+	std::atomic<int> recieved(0);
+	std::atomic<size_t> largest(0);
+
+	EXPECT_THROW(
+		{
+			tamgef::queue::QueuePoller<int> queue_poller(
+					queue_reader, batch_handler(), 8);
+		}, 
+		std::invalid_argument);
+
+	EXPECT_THROW(
+		{
+			tamgef::queue::QueuePoller<int> queue_poller(
+					queue_reader, [](int const*, size_t) {}, 0);
+		}, 
+		std::invalid_argument);
+
+	for (int i = 0; i < sent; ++i)
+		queue_ptr->enqueue(i);
+
+	{
+		tamgef::queue::QueuePoller<int> queue_poller(
+				queue_reader,
+				[&](int const* first, size_t count)
+				{
+					// messages stay in order
+					for (size_t i = 0; i < count; ++i)
+						EXPECT_EQ(first[i], recieved.load() + int(i));
+
+					recieved.fetch_add(count);
+
+					if (count > largest.load())
+						largest.store(count);
+				},
+				64,
+				std::chrono::microseconds(100));
+
+		std::this_thread::sleep_for(timeout);
+	}
+
+	EXPECT_EQ(recieved.load(), sent);
+	EXPECT_EQ(largest.load(), 64);
+}
+
+
+// has no default constructor, so is dequeued in place
+struct poller_sample
+{
+	explicit poller_sample(int value) : value(value) {}
+	int value;
+};
+
+TEST(QueuePollerTest, no_default_constructor)
+{
+	auto timeout(std::chrono::milliseconds(10));
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<poller_sample>>();
+	auto batch_queue_ptr = std::make_shared<tamgef::queue::Queue<poller_sample>>();
+	std::atomic<int> recieved(0);
+	std::atomic<int> batched(0);
+
+	queue_ptr->enqueue(poller_sample(1));
+	batch_queue_ptr->enqueue(poller_sample(2));
+	batch_queue_ptr->enqueue(poller_sample(3));
+
+	{
+		tamgef::queue::QueuePoller<poller_sample> queue_poller(
+				tamgef::queue::QueueReader<poller_sample>(queue_ptr),
+				[&recieved](poller_sample message)
+				{
+					recieved.fetch_add(message.value);
+				});
+
+		tamgef::queue::QueuePoller<poller_sample> batch_poller(
+				tamgef::queue::QueueReader<poller_sample>(batch_queue_ptr),
+				[&batched](poller_sample const* first, size_t count)
+				{
+					for (size_t i = 0; i < count; ++i)
+						batched.fetch_add(first[i].value);
+				},
+				4);
+
+		// I know, I know
+		std::this_thread::sleep_for(timeout);
+		EXPECT_TRUE(queue_poller.polling());
+	}
+
+	EXPECT_EQ(recieved.load(), 1);
+	EXPECT_EQ(batched.load(), 2 + 3);
+}
@@ -47,3 +47,52 @@ TEST_F(QueueReaderTest, expired)
 
 	EXPECT_TRUE(queue_reader_connected_ptr->expired());
 }
+
+TEST_F(QueueReaderTest, pin)
+{
+	int element(0);
+
+	EXPECT_THROW(queue_reader_empty_ptr->pin(), std::runtime_error);
+
+	queue_ptr->enqueue(1);
+	queue_ptr->enqueue(2);
+
+	{
+		auto pinned = queue_reader_connected_ptr->pin();
+
+		// the session keeps the queue alive
+		queue_ptr.reset();
+		EXPECT_FALSE(queue_reader_connected_ptr->expired());
+
+		EXPECT_EQ(pinned.size(), 2);
+		EXPECT_TRUE(pinned.tryDequeue(element));
+		EXPECT_EQ(element, 1);
+		EXPECT_EQ(pinned.tryDequeueBulk(&element, 1), 1);
+		EXPECT_EQ(element, 2);
+		EXPECT_TRUE(pinned.empty());
+	}
+
+	EXPECT_TRUE(queue_reader_connected_ptr->expired());
+	EXPECT_THROW(queue_reader_connected_ptr->pin(), std::runtime_error);
+}
+
+TEST_F(QueueReaderTest, readers)
+{
+	EXPECT_EQ(queue_ptr->readers(), 1);
+
+	{
+		// copies count, moves don't
+		tamgef::queue::QueueReader<int> copy(*queue_reader_connected_ptr);
+		tamgef::queue::QueueReader<int> moved(std::move(copy));
+		EXPECT_EQ(queue_ptr->readers(), 2);
+	}
+
+	EXPECT_EQ(queue_ptr->readers(), 1);
+
+	queue_reader_empty_ptr->connect(queue_ptr);
+	EXPECT_EQ(queue_ptr->readers(), 2);
+
+	queue_reader_empty_ptr->disconnect();
+	queue_reader_connected_ptr.reset();
+	EXPECT_EQ(queue_ptr->readers(), 0);
+}
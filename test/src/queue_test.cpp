@@ -0,0 +1,198 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <queue/queue.h>
+#include <queue/queue_reader.h>
+
+TEST(QueueTest, bulk)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<int>>();
+	tamgef::queue::QueueReader<int> queue_reader(queue_ptr);
+	std::vector<int> sent({ 1, 2, 3, 4, 5 });
+	std::vector<int> recieved(sent.size() + 1);
+
+	queue_ptr->enqueueBulk(sent.data(), sent.size());
+	EXPECT_EQ(queue_ptr->size(), sent.size());
+
+	// dequeues no more than is available
+	EXPECT_EQ(queue_reader.tryDequeueBulk(recieved.data(), recieved.size()), 
+			sent.size());
+	EXPECT_TRUE(std::equal(sent.begin(), sent.end(), recieved.begin()));
+	EXPECT_EQ(queue_reader.tryDequeueBulk(recieved.data(), recieved.size()), 0);
+
+	queue_reader.disconnect();
+	EXPECT_THROW(queue_reader.tryDequeueBulk(recieved.data(), recieved.size()),
+			std::runtime_error);
+}
+
+// has no default constructor, so can only be read with tryDequeue
+struct sample
+{
+	explicit sample(int value) : value(value) {}
+	int value;
+};
+
+TEST(QueueTest, try_dequeue)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<sample>>(
+			2, tamgef::queue::OverflowPolicy::DropOldest);
+	tamgef::queue::QueueReader<sample> queue_reader(queue_ptr);
+	sample recieved(0);
+
+	EXPECT_FALSE(queue_reader.tryDequeue(recieved));
+	EXPECT_EQ(recieved.value, 0);
+
+	queue_ptr->enqueue(sample(1));
+	queue_ptr->enqueue(sample(2));
+	queue_ptr->enqueue(sample(3));
+
+	EXPECT_TRUE(queue_reader.tryDequeue(recieved));
+	EXPECT_EQ(recieved.value, 2);
+	EXPECT_TRUE(queue_reader.tryDequeue(recieved));
+	EXPECT_EQ(recieved.value, 3);
+	EXPECT_FALSE(queue_reader.tryDequeue(recieved));
+	EXPECT_EQ(recieved.value, 3);
+
+	queue_reader.disconnect();
+	EXPECT_THROW(queue_reader.tryDequeue(recieved), std::runtime_error);
+}
+
+TEST(QueueTest, producer_consumer)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<int>>();
+	tamgef::queue::QueueReader<int> queue_reader(queue_ptr);
+	auto producer = queue_ptr->producer();
+	auto consumer = queue_reader.consumer();
+	int recieved(0);
+
+	ASSERT_TRUE(producer);
+	EXPECT_FALSE(consumer.tryDequeue(recieved));
+
+	producer->enqueue(10);
+	EXPECT_TRUE(consumer.tryDequeue(recieved));
+	EXPECT_EQ(recieved, 10);
+
+	// sessions and the plain interface share the queue
+	queue_ptr->enqueue(20);
+	EXPECT_TRUE(consumer.tryDequeue(recieved));
+	EXPECT_EQ(recieved, 20);
+
+	producer.reset();
+	queue_ptr.reset();
+	EXPECT_TRUE(consumer.expired());
+	EXPECT_THROW(consumer.tryDequeue(recieved), std::runtime_error);
+}
+
+TEST(QueueTest, drop_oldest)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<int>>(
+			2, tamgef::queue::OverflowPolicy::DropOldest);
+	tamgef::queue::QueueReader<int> queue_reader(queue_ptr);
+	std::vector<int> sent({ 4, 5, 6 });
+
+	queue_ptr->enqueue(1);
+	queue_ptr->enqueue(2);
+	queue_ptr->enqueue(3);
+
+	EXPECT_EQ(queue_reader.overflows(), 1);
+	EXPECT_EQ(queue_reader.drops(), 1);
+	EXPECT_EQ(queue_reader.dequeue(), 2);
+	EXPECT_EQ(queue_reader.dequeue(), 3);
+
+	queue_ptr->enqueueBulk(sent.data(), sent.size());
+
+	EXPECT_EQ(queue_reader.drops(), 2);
+	EXPECT_EQ(queue_reader.dequeue(), 5);
+	EXPECT_EQ(queue_reader.dequeue(), 6);
+	EXPECT_TRUE(queue_reader.empty());
+}
+
+TEST(QueueTest, drop_newest)
+{
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<int>>(
+			2, tamgef::queue::OverflowPolicy::DropNewest);
+	tamgef::queue::QueueReader<int> queue_reader(queue_ptr);
+	auto producer = queue_ptr->producer();
+	std::vector<int> sent({ 1, 2, 3 });
+
+	producer->enqueueBulk(sent.data(), sent.size());
+	producer->enqueue(4);
+
+	EXPECT_EQ(queue_reader.overflows(), 2);
+	EXPECT_EQ(queue_reader.drops(), 2);
+	EXPECT_EQ(queue_reader.dequeue(), 1);
+	EXPECT_EQ(queue_reader.dequeue(), 2);
+	EXPECT_TRUE(queue_reader.empty());
+}
+
+TEST(QueueTest, block)
+{
+	auto timeout(std::chrono::milliseconds(10));
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<int>>(
+			1, tamgef::queue::OverflowPolicy::Block, timeout);
+	tamgef::queue::QueueReader<int> queue_reader(queue_ptr);
+
+	queue_ptr->enqueue(1);
+
+	// nobody dequeues, times out and drops
+	auto start = std::chrono::steady_clock::now();
+	queue_ptr->enqueue(2);
+	EXPECT_GE(std::chrono::steady_clock::now() - start, timeout);
+	EXPECT_EQ(queue_reader.drops(), 1);
+
+	std::thread consumer([&]
+			{
+				std::this_thread::sleep_for(timeout / 2);
+				queue_reader.dequeue();
+			});
+
+	// unblocked by the consumer
+	queue_ptr->enqueue(3);
+	consumer.join();
+
+	EXPECT_EQ(queue_reader.drops(), 1);
+	EXPECT_EQ(queue_reader.dequeue(), 3);
+}
+
+TEST(QueueTest, soak)
+{
+	const size_t capacity(1 << 10);
+	const size_t sent(1 << 20);
+	tamgef::queue::Queue<int> queue(capacity);
+	auto producer = queue.producer();
+
+	// nobody reads, memory stays bounded by capacity
+	for (size_t i = 0; i < sent; ++i)
+	{
+		producer->enqueue(i);
+		ASSERT_LE(queue.size(), capacity);
+	}
+
+	EXPECT_EQ(queue.size(), capacity);
+	EXPECT_EQ(queue.drops(), sent - capacity);
+}
+
+TEST(QueueTest, wait)
+{
+	auto timeout(std::chrono::milliseconds(10));
+	auto queue_ptr = std::make_shared<tamgef::queue::Queue<int>>();
+	tamgef::queue::QueueReader<int> queue_reader(queue_ptr);
+
+	EXPECT_FALSE(queue_reader.wait(timeout));
+
+	std::thread producer([&]
+			{
+				std::this_thread::sleep_for(timeout / 2);
+				queue_ptr->enqueue(1);
+			});
+
+	// woken by the producer well before the timeout
+	EXPECT_TRUE(queue_reader.wait(std::chrono::seconds(10)));
+	EXPECT_EQ(queue_reader.dequeue(), 1);
+	producer.join();
+
+	queue_ptr->enqueue(2);
+	EXPECT_TRUE(queue_reader.wait(std::chrono::microseconds::zero()));
+}
@@ -0,0 +1,132 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <queue/queue_reader.h>
+#include <queue/ring_queue.h>
+
+TEST(RingQueueTest, constructor)
+{
+	EXPECT_THROW(tamgef::queue::RingQueue<int>(0), std::invalid_argument);
+
+	// rounds up to a power of two
+	EXPECT_EQ(tamgef::queue::RingQueue<int>(1).capacity(), 1);
+	EXPECT_EQ(tamgef::queue::RingQueue<int>(5).capacity(), 8);
+	EXPECT_EQ(tamgef::queue::RingQueue<int>(8).capacity(), 8);
+}
+
+TEST(RingQueueTest, overflow)
+{
+	tamgef::queue::RingQueue<int> ring_queue(2);
+	std::vector<int> elements({ 1, 2, 3 });
+
+	EXPECT_TRUE(ring_queue.tryEnqueue(1));
+	EXPECT_TRUE(ring_queue.tryEnqueue(2));
+	EXPECT_FALSE(ring_queue.tryEnqueue(3));
+	EXPECT_THROW(ring_queue.enqueue(3), std::overflow_error);
+
+	EXPECT_EQ(ring_queue.dequeue(), 1);
+	EXPECT_EQ(ring_queue.dequeue(), 2);
+	EXPECT_TRUE(ring_queue.empty());
+
+	EXPECT_THROW(ring_queue.enqueueBulk(elements.data(), elements.size()),
+			std::overflow_error);
+	EXPECT_TRUE(ring_queue.empty());
+
+	// keeps what fits
+	EXPECT_EQ(ring_queue.tryEnqueueBulk(elements.data(), elements.size()), 2);
+	EXPECT_EQ(ring_queue.dequeue(), 1);
+	EXPECT_EQ(ring_queue.producer()->tryEnqueueBulk(elements.data() + 2, 1), 1);
+	EXPECT_FALSE(ring_queue.producer()->tryEnqueue(4));
+}
+
+TEST(RingQueueTest, producer_consumer)
+{
+	const int sent(1 << 16);
+	auto ring_queue_ptr = std::make_shared<tamgef::queue::RingQueue<int>>(64);
+	tamgef::queue::QueueReader<int> queue_reader(ring_queue_ptr);
+
+	std::thread producer([&]
+			{
+				for (int i = 0; i < sent; ++i)
+					while (!ring_queue_ptr->tryEnqueue(i))
+						std::this_thread::yield();
+			});
+
+	auto consumer = queue_reader.consumer();
+	int expected(0), recieved(0);
+
+	while (expected < sent)
+	{
+		if (!consumer.tryDequeue(recieved))
+			continue;
+
+		// elements arrive once and in order
+		ASSERT_EQ(recieved, expected);
+		++expected;
+	}
+
+	producer.join();
+	EXPECT_TRUE(ring_queue_ptr->empty());
+}
+
+TEST(RingQueueTest, wait)
+{
+	auto timeout(std::chrono::milliseconds(10));
+	tamgef::queue::RingQueue<int> ring_queue(4);
+
+	EXPECT_FALSE(ring_queue.wait(timeout));
+
+	std::thread producer([&]
+			{
+				std::this_thread::sleep_for(timeout / 2);
+				ring_queue.enqueue(1);
+			});
+
+	EXPECT_TRUE(ring_queue.wait(std::chrono::seconds(10)));
+	producer.join();
+}
+
+TEST(RingQueueTest, loan)
+{
+	auto ring_queue_ptr = std::make_shared<tamgef::queue::RingQueue<int>>(4);
+	auto producer = ring_queue_ptr->producer();
+	int* slot(nullptr);
+	const int* first(nullptr);
+
+	// filled in place, only visible once committed
+	slot = producer->claim();
+	ASSERT_NE(slot, nullptr);
+	*slot = 1;
+	EXPECT_TRUE(ring_queue_ptr->empty());
+	producer->commit();
+	EXPECT_EQ(ring_queue_ptr->size(), 1);
+
+	// contiguous claims stop at the end of the ring
+	ASSERT_EQ(ring_queue_ptr->claim(slot, 8), 3);
+	slot[0] = 2;
+	slot[1] = 3;
+	ring_queue_ptr->commit(2);
+
+	ASSERT_EQ(ring_queue_ptr->view(first), 3);
+	EXPECT_EQ(first[0], 1);
+	EXPECT_EQ(first[2], 3);
+	ring_queue_ptr->release(3);
+	EXPECT_TRUE(ring_queue_ptr->empty());
+
+	ASSERT_EQ(ring_queue_ptr->claim(slot, 8), 1);
+	*slot = 4;
+	ring_queue_ptr->commit();
+	ASSERT_EQ(ring_queue_ptr->claim(slot, 8), 3);
+	ring_queue_ptr->commit(3);
+
+	// nothing to lend while full
+	EXPECT_EQ(ring_queue_ptr->claim(), nullptr);
+	EXPECT_EQ(ring_queue_ptr->claim(slot, 8), 0);
+
+	ASSERT_EQ(ring_queue_ptr->view(first), 1);
+	EXPECT_EQ(*first, 4);
+	ring_queue_ptr->release(1);
+	EXPECT_EQ(ring_queue_ptr->view(first), 3);
+}
@@ -0,0 +1,66 @@
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+#include <queue/shared_memory_queue.h>
+
+// one iteration is two hops, ping to an echo process and back again,
+// spinning on the rings or, with UseWait, sleeping on their futexes
+template<bool UseWait>
+static void shared_memory_queue_round_trip(benchmark::State & state)
+{
+	const std::chrono::milliseconds timeout(1);
+	auto prefix = "/tamgef_benchmark_" + std::to_string(::getpid());
+	tamgef::queue::SharedMemoryQueue<int> ping(prefix + "_ping", 1024);
+	tamgef::queue::SharedMemoryQueue<int> pong(prefix + "_pong", 1024);
+
+	pid_t child = ::fork();
+
+	if (child == -1)
+		throw std::runtime_error("Can't fork echo process");
+
+	// echoes until it reads -1
+	if (child == 0)
+	{
+		tamgef::queue::SharedMemoryQueue<int> child_ping(prefix + "_ping");
+		tamgef::queue::SharedMemoryQueue<int> child_pong(prefix + "_pong");
+		int element(0);
+
+		while (element != -1)
+		{
+			if (child_ping.tryDequeue(element))
+				child_pong.enqueue(element);
+			else if (UseWait)
+				child_ping.wait(timeout);
+			else
+				std::this_thread::yield();
+		}
+
+		::_exit(0);
+	}
+
+	int element(0);
+
+	while (state.KeepRunning())
+	{
+		ping.enqueue(element);
+
+		while (!pong.tryDequeue(element))
+			if (UseWait)
+				pong.wait(timeout);
+			else
+				std::this_thread::yield();
+	}
+
+	ping.enqueue(-1);
+	::waitpid(child, nullptr, 0);
+}
+
+BENCHMARK_TEMPLATE(shared_memory_queue_round_trip, false);
+BENCHMARK_TEMPLATE(shared_memory_queue_round_trip, true);
@@ -0,0 +1,143 @@
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <queue/queue_reader.h>
+#include <queue/shared_memory_queue.h>
+
+// unique per test process, so parallel runs don't collide
+static std::string queue_name(std::string const& suffix)
+{
+	return "/tamgef_test_" + std::to_string(::getpid()) + "_" + suffix;
+}
+
+TEST(SharedMemoryQueueTest, constructor)
+{
+	auto name = queue_name("constructor");
+
+	EXPECT_THROW(tamgef::queue::SharedMemoryQueue<int>(name, 0), 
+			std::invalid_argument);
+	EXPECT_THROW(
+		{
+			tamgef::queue::SharedMemoryQueue<int> attached(name);
+		},
+		std::runtime_error);
+
+	{
+		tamgef::queue::SharedMemoryQueue<int> created(name, 5);
+		EXPECT_EQ(created.capacity(), 8);
+
+		// one creator per name, attaching checks the element type
+		EXPECT_THROW(tamgef::queue::SharedMemoryQueue<int>(name, 5), 
+				std::runtime_error);
+		EXPECT_THROW(
+			{
+				tamgef::queue::SharedMemoryQueue<double> attached(name);
+			},
+			std::runtime_error);
+
+		tamgef::queue::SharedMemoryQueue<int> attached(name);
+		EXPECT_EQ(attached.capacity(), 8);
+	}
+
+	// unlinked with its creator
+	EXPECT_THROW(
+		{
+			tamgef::queue::SharedMemoryQueue<int> attached(name);
+		},
+		std::runtime_error);
+}
+
+TEST(SharedMemoryQueueTest, attach)
+{
+	auto name = queue_name("attach");
+	tamgef::queue::SharedMemoryQueue<int> created(name, 4);
+	auto attached_ptr = 
+		std::make_shared<tamgef::queue::SharedMemoryQueue<int>>(name);
+	tamgef::queue::QueueReader<int> queue_reader(attached_ptr);
+	int recieved(0);
+
+	created.enqueue(1);
+	created.enqueue(2);
+	EXPECT_EQ(queue_reader.size(), 2);
+
+	EXPECT_TRUE(queue_reader.tryDequeue(recieved));
+	EXPECT_EQ(recieved, 1);
+	EXPECT_TRUE(queue_reader.tryDequeue(recieved));
+	EXPECT_EQ(recieved, 2);
+	EXPECT_FALSE(queue_reader.tryDequeue(recieved));
+
+	EXPECT_FALSE(queue_reader.wait(std::chrono::milliseconds(1)));
+
+	for (int i = 0; i < 4; ++i)
+		EXPECT_TRUE(created.tryEnqueue(i));
+
+	EXPECT_FALSE(created.tryEnqueue(4));
+	EXPECT_THROW(created.enqueue(4), std::overflow_error);
+	EXPECT_TRUE(queue_reader.wait(std::chrono::milliseconds(1)));
+}
+
+TEST(SharedMemoryQueueTest, processes)
+{
+	const int sent(1 << 14);
+	auto ping_name = queue_name("ping");
+	auto pong_name = queue_name("pong");
+	auto timeout(std::chrono::seconds(10));
+
+	tamgef::queue::SharedMemoryQueue<int> ping(ping_name, 64);
+	tamgef::queue::SharedMemoryQueue<int> pong(pong_name, 64);
+
+	pid_t child = ::fork();
+	ASSERT_NE(child, -1);
+
+	// echoes every element back, doubled
+	if (child == 0)
+	{
+		int status(0);
+
+		try
+		{
+			tamgef::queue::SharedMemoryQueue<int> child_ping(ping_name);
+			tamgef::queue::SharedMemoryQueue<int> child_pong(pong_name);
+			int element;
+
+			for (int i = 0; i < sent; ++i)
+			{
+				while (!child_ping.tryDequeue(element))
+					if (!child_ping.wait(timeout))
+						throw std::runtime_error("Timed out");
+
+				while (!child_pong.tryEnqueue(2 * element))
+					std::this_thread::yield();
+			}
+		}
+		catch (...)
+		{
+			status = 1;
+		}
+
+		::_exit(status);
+	}
+
+	int recieved(0);
+
+	for (int i = 0; i < sent; ++i)
+	{
+		ping.enqueue(i);
+
+		while (!pong.tryDequeue(recieved))
+			ASSERT_TRUE(pong.wait(timeout));
+
+		ASSERT_EQ(recieved, 2 * i);
+	}
+
+	int status(0);
+	ASSERT_EQ(::waitpid(child, &status, 0), child);
+	EXPECT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(WEXITSTATUS(status), 0);
+}